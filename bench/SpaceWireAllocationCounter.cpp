@@ -0,0 +1,32 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "SpaceWireAllocationCounter.h"
+
+namespace
+{
+    std::atomic<U64> gAllocations( 0 );
+}
+
+U64 GetAllocationCount()
+{
+    return gAllocations.load();
+}
+
+// array new and delete go through these too
+void* operator new( std::size_t size )
+{
+    gAllocations.fetch_add( 1, std::memory_order_relaxed );
+    void* memory = std::malloc( ( size != 0 ) ? size : 1 );
+    if( memory == NULL )
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete( void* memory ) noexcept
+{
+    std::free( memory );
+}
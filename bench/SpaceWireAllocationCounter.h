@@ -0,0 +1,7 @@
+#pragma once
+
+#include <LogicPublicTypes.h>
+
+// return the number of heap allocations made so far by any thread
+// (global operator new is replaced to count them)
+U64 GetAllocationCount();
@@ -0,0 +1,504 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpaceWireAllocationCounter.h"
+#include "SpaceWireAnalyzer.h"
+#include "SpaceWireAnalyzerSettings.h"
+#include "SpaceWireBitStream.h"
+#include "SpaceWireCharacterDecoder.h"
+#include "SpaceWireEncoder.h"
+#include "SpaceWireFrameBuilder.h"
+
+// decoder throughput benchmark
+//
+// runs the three decode loops of the analyzer (single thread, pipelined and segmented) over edge
+// arrays, either synthesized with SpaceWireEncoder or loaded from files, and writes the results to
+// stdout as JSON.  the loops and the frame building are those of SpaceWireFrameBuilder with the
+// default analyzer settings, only the results object of the SDK (which only exists inside Logic)
+// is replaced by a sink that counts the frames.  the idle and mixed rate captures are also decoded
+// with NULLs and FCTs shown, with and without runs of them collapsed into one frame.
+//
+// usage: SpaceWireBenchmark [--characters N] [--repeat N] [--edges DATA STROBE SAMPLE_RATE_HZ]
+// edge files hold the sample numbers of the transitions as little-endian 64-bit integers, and both
+// lines are low before the first one.
+
+namespace
+{
+    // sample rate of the synthesized captures
+    const U32 kSampleRateHz = 500000000;
+    // bits counted at a time
+    const U32 kBitBlockSize = 4096;
+
+    // decode loops of SpaceWireFrameBuilder
+    enum ModeEnum
+    {
+        kModeStream,
+        kModePipelined,
+        kModeSegmented,
+        kModeCount,
+    };
+
+    const char* const kModeNames[ kModeCount ] = { "stream", "pipelined", "segmented" };
+
+    // edge source reading from an array of edge samples, standing in for AnalyzerChannelData
+    class ArrayEdgeSource : public SpaceWireEdgeSource
+    {
+      public:
+        ArrayEdgeSource() : mEdges( NULL ), mNext( 0 )
+        {
+        }
+
+        // start from sample 0 with the line low
+        void Reset( const std::vector<U64>* edges )
+        {
+            mEdges = edges;
+            mNext = 0;
+        }
+
+        virtual U64 GetSampleNumber()
+        {
+            return ( mNext == 0 ) ? 0 : ( *mEdges )[ mNext - 1 ];
+        }
+        virtual BitState GetBitState()
+        {
+            return ( ( mNext & 1 ) != 0 ) ? BIT_HIGH : BIT_LOW;
+        }
+        virtual U32 FetchEdges( U64* edges, U32 maxCount )
+        {
+            size_t count = mEdges->size() - mNext;
+            if( count > maxCount )
+            {
+                count = maxCount;
+            }
+            if( count != 0 )
+            {
+                memcpy( edges, &( *mEdges )[ mNext ], count * sizeof( U64 ) );
+            }
+            mNext += count;
+            return ( U32 )count;
+        }
+
+      protected:
+        const std::vector<U64>* mEdges;
+        // index of the next edge
+        size_t mNext;
+    };
+
+    // frame sink that only counts, standing in for the results of the analyzer
+    class CountingFrameSink : public SpaceWireFrameSink
+    {
+      public:
+        CountingFrameSink() : mFrames( 0 ), mPackets( 0 )
+        {
+        }
+
+        virtual void AddFrame( const Frame& )
+        {
+            ++mFrames;
+        }
+        virtual void CommitFrames( const LinkStatisticsStruct&, const TimecodeStatisticsStruct& )
+        {
+        }
+        virtual void CancelPacket()
+        {
+        }
+        virtual U64 CommitPacket( U64, U64, U8 )
+        {
+            return mPackets++;
+        }
+        virtual U64 AddRmapTransaction( const RmapTransactionStruct& transaction )
+        {
+            mRmapTransactions.push_back( transaction );
+            return mRmapTransactions.size() - 1;
+        }
+        virtual RmapTransactionStruct GetRmapTransaction( U64 transactionId )
+        {
+            return mRmapTransactions[ transactionId ];
+        }
+        virtual void SetRmapTransaction( U64 transactionId, const RmapTransactionStruct& transaction )
+        {
+            mRmapTransactions[ transactionId ] = transaction;
+        }
+        virtual void AddPacketToTransaction( U64, U64 )
+        {
+        }
+        virtual void ReportDecodeProgress( U64 )
+        {
+        }
+
+        U64 mFrames;
+        U64 mPackets;
+        std::vector<RmapTransactionStruct> mRmapTransactions;
+    };
+
+    // edges of one direction of a link
+    struct CaptureStruct
+    {
+        std::string name;
+        U32 sampleRateHz;
+        std::vector<U64> dataEdges;
+        std::vector<U64> strobeEdges;
+    };
+
+    // result of decoding a capture once
+    struct RunStruct
+    {
+        U64 bits;
+        U64 characters;
+        U64 frames;
+        U64 allocations;
+        double seconds;
+    };
+
+    U32 Random( U32& state )
+    {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // add a packet of random length with its EOP, returns the number of characters added
+    U64 AddPacket( SpaceWireEncoder& encoder, U32& random )
+    {
+        U32 length = 16 + Random( random ) % 1009;
+        for( U32 i = 0; i < length; ++i )
+        {
+            encoder.AddData( ( U8 )i );
+        }
+        encoder.AddControl( SpaceWireAnalyzer::kControlEop );
+        return length + 1;
+    }
+
+    void TakeEdges( SpaceWireEncoder& encoder, CaptureStruct& capture )
+    {
+        capture.sampleRateHz = kSampleRateHz;
+        capture.dataEdges = encoder.GetDataEdges();
+        capture.strobeEdges = encoder.GetStrobeEdges();
+    }
+
+    // NULLs only, as on an idle link
+    void BuildIdle( U64 characters, CaptureStruct& capture )
+    {
+        SpaceWireEncoder encoder;
+        encoder.Reset( 100 );
+        encoder.SetBitRate( kSampleRateHz, 100000000 );
+        for( U64 count = 0; count < characters; count += 2 )
+        {
+            encoder.AddNull();
+        }
+        capture.name = "idle_nulls";
+        TakeEdges( encoder, capture );
+    }
+
+    // packets without gaps between them
+    void BuildPackets( U64 characters, CaptureStruct& capture )
+    {
+        SpaceWireEncoder encoder;
+        encoder.Reset( 100 );
+        encoder.SetBitRate( kSampleRateHz, 100000000 );
+        U32 random = 1;
+        for( U64 count = 0; count < characters; )
+        {
+            count += AddPacket( encoder, random );
+        }
+        capture.name = "back_to_back_packets";
+        TakeEdges( encoder, capture );
+    }
+
+    // packets with a burst of parity errors and coincident edges every few thousand characters
+    void BuildErrorBursts( U64 characters, CaptureStruct& capture )
+    {
+        SpaceWireEncoder encoder;
+        encoder.Reset( 100 );
+        encoder.SetBitRate( kSampleRateHz, 100000000 );
+        U32 random = 1;
+        U64 nextBurst = 5000;
+        for( U64 count = 0; count < characters; )
+        {
+            count += AddPacket( encoder, random );
+            encoder.AddNull();
+            count += 2;
+            if( count >= nextBurst )
+            {
+                for( U32 i = 0; i < 16; ++i )
+                {
+                    if( ( Random( random ) & 1 ) != 0 )
+                    {
+                        encoder.CorruptNextParity();
+                    }
+                    else
+                    {
+                        encoder.AddCoincidentEdges();
+                    }
+                    encoder.AddData( ( U8 )Random( random ) );
+                }
+                // NULLs to get back in sync
+                for( U32 i = 0; i < 4; ++i )
+                {
+                    encoder.AddNull();
+                }
+                count += 16 + 8;
+                nextBurst = count + 5000;
+            }
+        }
+        capture.name = "error_bursts";
+        TakeEdges( encoder, capture );
+    }
+
+    // packets separated by NULLs with the link rate changing every few thousand characters
+    void BuildMixedRates( U64 characters, CaptureStruct& capture )
+    {
+        const U64 kRatesBps[] = { 10000000, 50000000, 100000000, 200000000 };
+        SpaceWireEncoder encoder;
+        encoder.Reset( 100 );
+        U32 random = 1;
+        U32 rate = 0;
+        U64 nextChange = 0;
+        for( U64 count = 0; count < characters; )
+        {
+            if( count >= nextChange )
+            {
+                encoder.SetBitRate( kSampleRateHz, kRatesBps[ rate ] );
+                rate = ( rate + 1 ) % ( sizeof( kRatesBps ) / sizeof( kRatesBps[ 0 ] ) );
+                nextChange = count + 5000;
+            }
+            count += AddPacket( encoder, random );
+            for( U32 i = 0; i < 4; ++i )
+            {
+                encoder.AddNull();
+            }
+            count += 8;
+        }
+        capture.name = "mixed_link_rates";
+        TakeEdges( encoder, capture );
+    }
+
+    bool LoadEdges( const char* path, std::vector<U64>& edges )
+    {
+        FILE* file = fopen( path, "rb" );
+        if( file == NULL )
+        {
+            return false;
+        }
+        U8 bytes[ 8 ];
+        while( fread( bytes, 1, sizeof( bytes ), file ) == sizeof( bytes ) )
+        {
+            U64 edge = 0;
+            for( U32 i = 0; i < 8; ++i )
+            {
+                edge |= ( U64 )bytes[ i ] << ( 8 * i );
+            }
+            edges.push_back( edge );
+        }
+        fclose( file );
+        return true;
+    }
+
+    // set up a bit stream over a capture as the analyzer does
+    void ResetBitStream( const CaptureStruct& capture, const SpaceWireAnalyzerSettings& settings, ArrayEdgeSource& data,
+                         ArrayEdgeSource& strobe, SpaceWireBitStream& bitStream )
+    {
+        data.Reset( &capture.dataEdges );
+        strobe.Reset( &capture.strobeEdges );
+        bitStream.Reset( &data, &strobe );
+        bitStream.SetSampleRate( capture.sampleRateHz );
+        bitStream.SetPairedEdgeSamples( settings.GetPairedEdgeSamples( capture.sampleRateHz ) );
+    }
+
+    // count the bits and characters of a capture, which don't depend on the decode loop
+    void CountBitsAndCharacters( const CaptureStruct& capture, const SpaceWireAnalyzerSettings& settings, U64& bits, U64& characters )
+    {
+        ArrayEdgeSource data;
+        ArrayEdgeSource strobe;
+        std::unique_ptr<SpaceWireBitStream> bitStream( new SpaceWireBitStream() );
+        ResetBitStream( capture, settings, data, strobe, *bitStream );
+        SpaceWireCharacterDecoder decoder;
+        decoder.Reset();
+        decoder.SetDesyncAfterError( settings.mDesyncAfterError );
+
+        std::vector<RecoveredBitStruct> block( kBitBlockSize );
+        std::vector<DecodedCharacterStruct> decoded;
+        bits = 0;
+        characters = 0;
+        U32 count;
+        while( ( count = bitStream->ReadBits( block.data(), kBitBlockSize ) ) != 0 )
+        {
+            bits += count;
+            decoder.Decode( block.data(), count, decoded );
+            characters += decoded.size();
+            decoded.clear();
+        }
+    }
+
+    RunStruct Run( const CaptureStruct& capture, const SpaceWireAnalyzerSettings& settings, ModeEnum mode )
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        // the frame builder and the bit stream hold blocks of bits and edges, too much for the
+        // stack of some platforms.  the analyzer keeps both from one decode to the next.
+        CountingFrameSink sink;
+        SpaceWireInstrumentation instrumentation;
+        std::unique_ptr<SpaceWireFrameBuilder> builder( new SpaceWireFrameBuilder( sink, instrumentation ) );
+        std::unique_ptr<SpaceWireBitStream> bitStream( new SpaceWireBitStream() );
+        ArrayEdgeSource data;
+        ArrayEdgeSource strobe;
+
+        RunStruct run;
+        run.bits = 0;
+        run.characters = 0;
+        U64 allocations = GetAllocationCount();
+        Clock::time_point start = Clock::now();
+
+        // the packet arena belongs to the results, which are new for every decode
+        SpaceWirePacketArena packetArena;
+        ResetBitStream( capture, settings, data, strobe, *bitStream );
+        builder->Reset( &settings, capture.sampleRateHz, 0, &packetArena, NULL );
+        switch( mode )
+        {
+        case kModePipelined:
+            builder->DecodePipelined( *bitStream );
+            break;
+        case kModeSegmented:
+            builder->DecodeSegments( *bitStream );
+            break;
+        default:
+            builder->DecodeStream( *bitStream );
+            break;
+        }
+        builder->Finish();
+
+        run.seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+        run.allocations = GetAllocationCount() - allocations;
+        run.frames = sink.mFrames;
+        return run;
+    }
+
+    void WriteResult( const std::string& scenario, const CaptureStruct& capture, ModeEnum mode, const RunStruct& run, bool first )
+    {
+        U64 edges = capture.dataEdges.size() + capture.strobeEdges.size();
+        double characters = ( run.characters != 0 ) ? ( double )run.characters : 1.0;
+        printf( "%s    {\"scenario\": \"%s\", \"mode\": \"%s\", \"sample_rate_hz\": %u, \"edges\": %llu, \"bits\": %llu, "
+                "\"characters\": %llu, \"frames\": %llu, \"seconds\": %.6f, \"mchar_per_s\": %.3f, \"mframe_per_s\": %.3f, "
+                "\"medges_per_s\": %.3f, \"allocations\": %llu, \"allocations_per_char\": %.6f}",
+                ( first ) ? "" : ",\n", scenario.c_str(), kModeNames[ mode ], capture.sampleRateHz,
+                ( unsigned long long )edges, ( unsigned long long )run.bits, ( unsigned long long )run.characters,
+                ( unsigned long long )run.frames, run.seconds, run.characters / run.seconds / 1e6, run.frames / run.seconds / 1e6,
+                edges / run.seconds / 1e6, ( unsigned long long )run.allocations, run.allocations / characters );
+    }
+
+    // decode a capture in every mode with the given settings and write the fastest run of each
+    void RunScenario( const std::string& scenario, const CaptureStruct& capture, const SpaceWireAnalyzerSettings& settings, U32 repeat,
+                      bool& first )
+    {
+        U64 bits;
+        U64 characters;
+        CountBitsAndCharacters( capture, settings, bits, characters );
+        for( U32 mode = 0; mode < kModeCount; ++mode )
+        {
+            RunStruct best = Run( capture, settings, ( ModeEnum )mode );
+            for( U32 r = 1; r < repeat; ++r )
+            {
+                RunStruct run = Run( capture, settings, ( ModeEnum )mode );
+                if( run.seconds < best.seconds )
+                {
+                    best = run;
+                }
+            }
+            best.bits = bits;
+            best.characters = characters;
+            WriteResult( scenario, capture, ( ModeEnum )mode, best, first );
+            first = false;
+        }
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    U64 characters = 4000000;
+    U32 repeat = 3;
+    std::vector<CaptureStruct> captures;
+    // the default settings of the analyzer, and with NULLs and FCTs shown, with and without runs
+    // of them collapsed into one frame
+    SpaceWireAnalyzerSettings settings;
+    SpaceWireAnalyzerSettings idleSettings;
+    idleSettings.mShowNulls = true;
+    idleSettings.mShowFcts = true;
+    SpaceWireAnalyzerSettings uncollapsedSettings;
+    uncollapsedSettings.mShowNulls = true;
+    uncollapsedSettings.mShowFcts = true;
+    uncollapsedSettings.mCollapseRuns = false;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        if( strcmp( argv[ i ], "--characters" ) == 0 && i + 1 < argc )
+        {
+            characters = strtoull( argv[ ++i ], NULL, 10 );
+        }
+        else if( strcmp( argv[ i ], "--repeat" ) == 0 && i + 1 < argc )
+        {
+            repeat = ( U32 )strtoul( argv[ ++i ], NULL, 10 );
+        }
+        else if( strcmp( argv[ i ], "--edges" ) == 0 && i + 3 < argc )
+        {
+            captures.push_back( CaptureStruct() );
+            CaptureStruct& capture = captures.back();
+            capture.name = argv[ i + 1 ];
+            if( !LoadEdges( argv[ i + 1 ], capture.dataEdges ) || !LoadEdges( argv[ i + 2 ], capture.strobeEdges ) )
+            {
+                fprintf( stderr, "can't read %s or %s\n", argv[ i + 1 ], argv[ i + 2 ] );
+                return 1;
+            }
+            capture.sampleRateHz = ( U32 )strtoul( argv[ i + 3 ], NULL, 10 );
+            i += 3;
+        }
+        else
+        {
+            fprintf( stderr, "usage: %s [--characters N] [--repeat N] [--edges DATA STROBE SAMPLE_RATE_HZ]\n", argv[ 0 ] );
+            return 1;
+        }
+    }
+    if( repeat == 0 )
+    {
+        repeat = 1;
+    }
+
+    // recorded captures replace the synthesized ones
+    bool synthesized = captures.empty();
+    if( synthesized )
+    {
+        captures.resize( 4 );
+        BuildIdle( characters, captures[ 0 ] );
+        BuildPackets( characters, captures[ 1 ] );
+        BuildErrorBursts( characters, captures[ 2 ] );
+        BuildMixedRates( characters, captures[ 3 ] );
+    }
+
+    printf( "{\n  \"hardware_threads\": %u,\n  \"repeat\": %u,\n  \"results\": [\n", std::thread::hardware_concurrency(), repeat );
+    bool first = true;
+    for( size_t c = 0; c < captures.size(); ++c )
+    {
+        RunScenario( captures[ c ].name, captures[ c ], settings, repeat, first );
+    }
+    if( synthesized )
+    {
+        // idle fill is hidden by default, the frames it takes when shown depend on collapsing
+        // (the mixed rate capture has four NULLs between packets)
+        const size_t kIdleCaptures[] = { 0, 3 };
+        for( size_t i = 0; i < sizeof( kIdleCaptures ) / sizeof( kIdleCaptures[ 0 ] ); ++i )
+        {
+            const CaptureStruct& capture = captures[ kIdleCaptures[ i ] ];
+            RunScenario( capture.name + "_shown", capture, idleSettings, repeat, first );
+            RunScenario( capture.name + "_shown_uncollapsed", capture, uncollapsedSettings, repeat, first );
+        }
+    }
+    printf( "\n  ]\n}\n" );
+    return 0;
+}
@@ -7,15 +7,17 @@
 /*
 
 The Frame object mType parameter is as follows:
-0: bare control character
+0: bare control character (mData2 = number of FCTs if a run of them was collapsed, otherwise 0)
 1: bare data character
-2: NULL
-3: timecode
-4: packet (mData1 = packet length (1 byte) + 63 bytes of data, mData2 = next 64 bytes)
-5: error packet
-6: escape error
-7: parity error
-8: link speed change (value is new rate, duration is first bit of new character)
+2: NULL (mData2 = number of NULLs if a run of them was collapsed, otherwise 0)
+3: timecode (mData1 = value, with the jitter in bits 8..63 if kFlagJitter is set, mData2 = delta since the last timecode)
+4: packet (mData1 = payload handle in the results packet arena, mData2 = packet length, kFlagRmap if the payload is RMAP)
+5: empty packet
+6: error packet (same as packet)
+7: escape error
+8: parity error
+9: link speed change (mData1 = new rate in bit/s, mData2 = previous rate, duration is first bit of new character)
+10: credit error (mData1 = 1 for underflow or 2 for overflow, mData2 = 0 for this direction or 1 for reverse)
 
 The Frame object mFlag parameter is as follows:
 
@@ -24,367 +26,189 @@ The Frame object mFlag parameter is as follows:
 
 */
 
-// constructor
-BufferedBitsStruct::BufferedBitsStruct() : count( 0 ), value( 0 )
+SpaceWireAnalyzer::SpaceWireAnalyzer()
+    : Analyzer2(), mSettings( new SpaceWireAnalyzerSettings() ), mSimulationInitialized( false ), mHasReverse( false ),
+      mFrameBuilder( *this, mInstrumentation ), mTraceComplete( false )
 {
+    SetAnalyzerSettings( mSettings.get() );
 }
 
-// push a new bit into the buffer
-// (can only be called when count < 12)
-void BufferedBitsStruct::Push( BitState state, U64 firstSampleOfBit )
+SpaceWireAnalyzer::~SpaceWireAnalyzer()
 {
-    value <<= 1;
-    if( state == BIT_HIGH )
+    KillThread();
+}
+
+void SpaceWireAnalyzer::SetupResults()
+{
+    mResults.reset( new SpaceWireAnalyzerResults( this, mSettings.get() ) );
+    SetAnalyzerResults( mResults.get() );
+    mResults->AddChannelBubblesWillAppearOn( mSettings->mDataChannel );
+}
+
+void SpaceWireAnalyzer::WorkerThread()
+{
+    mSampleRateHz = GetSampleRate();
+    mInstrumentation.Reset();
+
+    mData = GetAnalyzerChannelData( mSettings->mDataChannel );
+    mStrobe = GetAnalyzerChannelData( mSettings->mStrobeChannel );
+
+    U64 pairedEdgeSamples = mSettings->GetPairedEdgeSamples( mSampleRateHz );
+
+    // the reverse direction is only needed to track flow control credit
+    mHasReverse = mSettings->HasReverseChannels();
+    if( mHasReverse )
     {
-        value |= 1;
+        mReverseData = GetAnalyzerChannelData( mSettings->mReverseDataChannel );
+        mReverseStrobe = GetAnalyzerChannelData( mSettings->mReverseStrobeChannel );
+        mReverse.Reset( mReverseData, mReverseStrobe, mSampleRateHz, pairedEdgeSamples, mSettings->mDesyncAfterError );
     }
-    count += 1;
-    // save first sample of every other bit
-    if( count % 2 )
+
+    mFrameBuilder.Reset( mSettings.get(), mSampleRateHz, mData->GetSampleNumber(), &mResults->GetPacketArena(),
+                         ( mHasReverse ) ? &mReverse : NULL );
+
+    mDataEdges.SetChannel( mData );
+    mStrobeEdges.SetChannel( mStrobe );
+    mBitStream.Reset( &mDataEdges, &mStrobeEdges );
+    mBitStream.SetSampleRate( mSampleRateHz );
+    mBitStream.SetPairedEdgeSamples( pairedEdgeSamples );
+
+    // when only the display settings changed, the characters of the last decode still hold
+    bool replaying = CanReplayTrace();
+    mTraceEditCount = mSettings->mEditCount;
+    if( replaying )
+    {
+        mFrameBuilder.DecodeTrace( mTrace, mReverseTrace );
+    }
+    else
+    {
+        mTrace.Clear();
+        mReverseTrace.Clear();
+        mTraceComplete = false;
+        bool recording = mSettings->mKeepCharacters;
+        mTraceChannels[ 0 ] = mSettings->mDataChannel;
+        mTraceChannels[ 1 ] = mSettings->mStrobeChannel;
+        mTraceChannels[ 2 ] = mSettings->mReverseDataChannel;
+        mTraceChannels[ 3 ] = mSettings->mReverseStrobeChannel;
+        mTraceSampleRateHz = mSampleRateHz;
+        mTraceFirstSample = mData->GetSampleNumber();
+        if( recording )
+        {
+            GetFirstEdges( mTraceFirstEdges );
+            mFrameBuilder.SetRecording( &mTrace, &mReverseTrace );
+        }
+        mTraceDesyncAfterError = mSettings->mDesyncAfterError;
+        mTracePairedEdgeSamples = pairedEdgeSamples;
+
+        switch( mSettings->mDecodeMode )
+        {
+        case SpaceWireAnalyzerSettings::kDecodePipelined:
+            mFrameBuilder.DecodePipelined( mBitStream );
+            break;
+        case SpaceWireAnalyzerSettings::kDecodeSegmented:
+            mFrameBuilder.DecodeSegments( mBitStream );
+            break;
+        default:
+            mFrameBuilder.DecodeStream( mBitStream );
+            break;
+        }
+        mFrameBuilder.SetRecording( NULL, NULL );
+        mTraceComplete = recording && mTrace.IsComplete() && mReverseTrace.IsComplete();
+    }
+
+    mFrameBuilder.Finish();
+
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterEdges, mDataEdges.GetEdgeCount() + mStrobeEdges.GetEdgeCount() );
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls, mDataEdges.GetSdkCallCount() + mStrobeEdges.GetSdkCallCount() );
+    if( mHasReverse )
     {
-        firstSample[ 5 ] = firstSample[ 4 ];
-        firstSample[ 4 ] = firstSample[ 3 ];
-        firstSample[ 3 ] = firstSample[ 2 ];
-        firstSample[ 2 ] = firstSample[ 1 ];
-        firstSample[ 1 ] = firstSample[ 0 ];
-        firstSample[ 0 ] = firstSampleOfBit;
+        mInstrumentation.Count( SpaceWireInstrumentation::kCounterEdges, mReverse.GetEdgeCount() );
+        mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls, mReverse.GetSdkCallCount() );
     }
+    static const char* const kDecodeModeNames[] = { "single_thread", "pipelined", "segmented" };
+    mInstrumentation.Write( ( replaying ) ? "replay" : kDecodeModeNames[ mSettings->mDecodeMode ] );
 }
 
-// return the Xth bit in the buffer
-U8 BufferedBitsStruct::Get( U8 index ) const
+bool SpaceWireAnalyzer::CanReplayTrace()
 {
-    return ( value & ( ( U16 )1 << ( count - index - 1 ) ) ) ? 1 : 0;
+    // a rerun without a settings edit may be for new data, which can only be told from the edges
+    if( !mTraceComplete || !mSettings->mKeepCharacters || mSettings->mEditCount == mTraceEditCount )
+    {
+        return false;
+    }
+    U64 firstEdges[ 2 ];
+    GetFirstEdges( firstEdges );
+    return mTraceChannels[ 0 ] == mSettings->mDataChannel && mTraceChannels[ 1 ] == mSettings->mStrobeChannel &&
+           mTraceChannels[ 2 ] == mSettings->mReverseDataChannel && mTraceChannels[ 3 ] == mSettings->mReverseStrobeChannel &&
+           mTraceSampleRateHz == mSampleRateHz && mTraceFirstSample == mData->GetSampleNumber() &&
+           firstEdges[ 0 ] == mTraceFirstEdges[ 0 ] && firstEdges[ 1 ] == mTraceFirstEdges[ 1 ] &&
+           mTraceDesyncAfterError == mSettings->mDesyncAfterError &&
+           mTracePairedEdgeSamples == mSettings->GetPairedEdgeSamples( mSampleRateHz );
 }
 
-// return true if second parity bit matches
-bool BufferedBitsStruct::ParityMatch( unsigned int charLength ) const
+void SpaceWireAnalyzer::GetFirstEdges( U64 edges[ 2 ] )
 {
-    // calculate expected parity
-    U8 parity = 0;
-    for( unsigned int i = 2; i < charLength + 2; ++i )
+    AnalyzerChannelData* channels[ 2 ] = { mData, mStrobe };
+    for( U32 i = 0; i < 2; ++i )
     {
-        parity ^= Get( i );
+        edges[ i ] = ( channels[ i ]->DoMoreTransitionsExistInCurrentData() ) ? channels[ i ]->GetSampleOfNextEdge() : 0;
+        mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls, 2 );
     }
-    return parity == 0;
 }
 
-// pop an even number of characters
-// (can only be called when count == 6 or count == 12)
-void BufferedBitsStruct::Pop( U8 skip )
+void SpaceWireAnalyzer::AddFrame( const Frame& frame )
 {
-    count -= skip;
-    unsigned int delta = skip / 2;
+    mResults->AddFrame( frame );
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls );
 }
 
-
-SpaceWireAnalyzer::SpaceWireAnalyzer() : Analyzer2(), mSettings( new SpaceWireAnalyzerSettings() ), mSimulationInitialized( false )
+void SpaceWireAnalyzer::CommitFrames( const LinkStatisticsStruct& statistics, const TimecodeStatisticsStruct& timecodeStatistics )
 {
-    SetAnalyzerSettings( mSettings.get() );
+    mResults->CommitResults();
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls );
+    mResults->SetLinkStatistics( statistics );
+    mResults->SetTimecodeStatistics( timecodeStatistics );
 }
 
-SpaceWireAnalyzer::~SpaceWireAnalyzer()
+void SpaceWireAnalyzer::CancelPacket()
 {
-    KillThread();
+    mResults->CancelPacketAndStartNewPacket();
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls );
 }
 
-void SpaceWireAnalyzer::SetupResults()
+U64 SpaceWireAnalyzer::CommitPacket( U64 handle, U64 length, U8 endMarker )
 {
-    mResults.reset( new SpaceWireAnalyzerResults( this, mSettings.get() ) );
-    SetAnalyzerResults( mResults.get() );
-    mResults->AddChannelBubblesWillAppearOn( mSettings->mDataChannel );
+    U64 packetId = mResults->CommitPacketAndStartNewPacket();
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls );
+    mResults->AddPacketSummary( packetId, handle, length, endMarker );
+    return packetId;
 }
 
-void SpaceWireAnalyzer::Desync()
+U64 SpaceWireAnalyzer::AddRmapTransaction( const RmapTransactionStruct& transaction )
 {
-    mSynchronized = false;
-    mLastCharacterBitrateMbps = 0.0;
-    mPacketData.clear();
-    mEscPrefix = false;
-    mLastTimecode = 255;
-    mBits.count = 0;
+    return mResults->AddRmapTransaction( transaction );
 }
 
-void SpaceWireAnalyzer::AddFrame( U64 mData1, U64 mData2, U8 mType, U8 mFlags, U64 mStartingSampleInclusive, U64 mEndingSampleInclusive )
+RmapTransactionStruct SpaceWireAnalyzer::GetRmapTransaction( U64 transactionId )
 {
-    Frame frame;
-    frame.mData1 = mData1;
-    frame.mData2 = mData2;
-    frame.mType = mType;
-    frame.mFlags = mFlags;
-    frame.mStartingSampleInclusive = mStartingSampleInclusive;
-    frame.mEndingSampleInclusive = mEndingSampleInclusive;
-    mResults->AddFrame( frame );
-    mResults->CommitResults();
+    return mResults->GetRmapTransaction( transactionId );
 }
 
-void SpaceWireAnalyzer::WorkerThread()
+void SpaceWireAnalyzer::SetRmapTransaction( U64 transactionId, const RmapTransactionStruct& transaction )
 {
-    mSampleRateHz = GetSampleRate();
-
-    mData = GetAnalyzerChannelData( mSettings->mDataChannel );
-    mStrobe = GetAnalyzerChannelData( mSettings->mStrobeChannel );
-
-    // reset state variables to desynchronized state
-    Desync();
-
-    // if not synced:
-    // 1) if not synced and S = D, skip a bit and desync
-    // 2) wait for 2 bits to come in
-    // 2a) if two transitions ever happen at the exact same time, desync and goto 1
-    // 3) if second bit is 1, wait for 6 bits, else wait for 10 bits
-    // 4) if second bit is 1, check parity on 5th bit (2-4,6), else check parity on 9th bit (2-8, 10)
-    // 5) if parity matches, save frame and skip frame bits, else desync, skip 2 bits
-    // 6) in either case, goto 2
-
-    while( true )
-    {
-        // buffer up to 12 bits
-        while( 
-            mData->DoMoreTransitionsExistInCurrentData()
-            && mStrobe->DoMoreTransitionsExistInCurrentData()
-            && (mBits.count < 6 || mBits.Get(1) == 0 && mBits.count < 12))
-        {
-            // find next transition on each line
-            U64 dataTransition = mData->GetSampleOfNextEdge();
-            U64 strobeTransition = mStrobe->GetSampleOfNextEdge();
-
-            // last sample of this frame is just before transition
-            U64 nextFirstSample = ( dataTransition < strobeTransition ) ? dataTransition : strobeTransition;
-
-            // move channels past transition
-            U64 firstBitSample = mData->GetSampleNumber();
-            BitState dataState = mData->GetBitState();
-            BitState strobeState = mStrobe->GetBitState();
-            mData->AdvanceToAbsPosition( nextFirstSample );
-            mStrobe->AdvanceToAbsPosition( nextFirstSample );
-            ReportProgress( nextFirstSample - 1 );
-
-            // if they transition on the same sample, de-sync
-            if( dataTransition == strobeTransition )
-            {
-                Desync();
-                continue;
-            }
-
-            // if this is the first bit, skip it if D == S (since parity bit has D != S)
-            if( !mSynchronized && mBits.count == 0 && dataState == strobeState )
-            {
-                continue;
-            }
-
-            // add this bit
-            mBits.Push( dataState, firstBitSample );
-        }
-
-        // need at least 2 bits to interpret frame type
-        if( mBits.count < 2 )
-        {
-            break;
-        }
-
-        // character length
-        unsigned int charLength = mBits.Get( 1 ) ? 4 : 10;
-        // wait for more bits
-        if( mBits.count < charLength + 2 )
-        {
-            break;
-        }
+    mResults->SetRmapTransaction( transactionId, transaction );
+}
 
-        // get start/end samples of character
-        U64 startingSample = mBits.firstSample[ mBits.count / 2 - 1 ];
-        U64 endingSample = mBits.firstSample[ ( mBits.count - charLength ) / 2 - 1 ] - 1;
+void SpaceWireAnalyzer::AddPacketToTransaction( U64 transactionId, U64 packetId )
+{
+    mResults->AddPacketToTransaction( transactionId, packetId );
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls );
+}
 
-        // if parity matches, save a frame
-        if( mBits.ParityMatch( charLength ) || true )
-        {
-            // get type of character
-            bool controlChar = charLength == 4;
-            // get character value
-            U8 value = mBits.value >> ( mBits.count - charLength );
-            // trim or reverse data bits
-            if( controlChar )
-            {
-                value &= 0b11;
-            }
-            else
-            {
-                U8 x = value;
-                value = 0;
-                for( unsigned int i = 0; i < 8; ++i )
-                {
-                    value <<= 1;
-                    value |= x & 1;
-                    x >>= 1;
-                }
-            }
-            // pop bits from buffer
-            mBits.Pop( charLength );
-
-            // calculate bitrate
-            if( mSettings->mShowLinkSpeedChanges )
-            {
-                double thisCharBitrate = ( endingSample + 1 - startingSample ) / ( mSampleRateHz * 1e6 );
-                if( mLastCharacterBitrateMbps != 0.0 &&
-                    ( thisCharBitrate > mLastCharacterBitrateMbps * 1.5 || thisCharBitrate < mLastCharacterBitrateMbps / 1.5 ) )
-                {
-                    // TODO: report bit rate change
-                }
-                mLastCharacterBitrateMbps = thisCharBitrate;
-            }
-
-            // if we're not combining chars, just send it out
-            if( !mSettings->mCombineChars )
-            {
-                AddFrame( value, 0, ( controlChar ) ? kTypeControlCharacter : kTypeDataCharacter, 0, startingSample, endingSample );
-            }
-            else
-            {
-                // handle continuing ESC sequences
-                if( mEscPrefix )
-                {
-                    mEscPrefix = false;
-                    if( controlChar && value == kControlFct )
-                    {
-                        // ESC + FCT = NULL
-                        if( mSettings->mShowNulls )
-                        {
-                            AddFrame( value, 0, kTypeNull, 0, mEscPrefixStartingSample, endingSample );
-                        }
-                    }
-                    else if( !controlChar )
-                    {
-                        // ESC + DATA = TIMECODE
-                        // see if this matches the expected value
-                        U8 expectedValue = ( mLastTimecode + 1 ) % 64;
-                        bool matchesExpected = (mLastTimecode == 255 || value == expectedValue);
-                        // save results
-                        if( mSettings->mShowTimecodes || !matchesExpected && mSettings->mShowErrors )
-                        {
-                            // TIMECODE
-                            if( mSettings->mShowTimecodes )
-                            {
-                                U64 delta = 0;
-                                if( mLastTimecode != 255 )
-                                {
-                                    delta = mEscPrefixStartingSample - mLastTimecodeStartingSample;
-                                }
-                                AddFrame( value, delta, kTypeTimecode, (matchesExpected) ? 0 : kFlagWarning, mEscPrefixStartingSample, endingSample );
-                            }
-                        }
-                        // save timecode for later comparison
-                        mLastTimecode = value;
-                        mLastTimecodeStartingSample = mEscPrefixStartingSample;
-                    }
-                    else
-                    {
-                        // anything else is invalid
-                        if( mSettings->mShowErrors )
-                        {
-                            AddFrame( value, 0, kTypeEscapeError, kFlagError, mEscPrefixStartingSample, endingSample );
-                        }
-                    }
-                }
-                else
-                {
-                    if( controlChar )
-                    {
-                        if( value == kControlEsc )
-                        {
-                            mEscPrefix = true;
-                            mEscPrefixStartingSample = startingSample;
-                        }
-                        else if( value == kControlEop )
-                        {
-                            // end of frame
-                            if( mPacketData.empty() )
-                            {
-                                // empty packet error
-                                if( mSettings->mShowErrors )
-                                {
-                                    AddFrame( 0, 0, kTypeEmptyPacket, 0, startingSample, endingSample );
-                                }
-                            }
-                            else
-                            {
-                                // packet
-                                if( mSettings->mShowRegularPackets )
-                                {
-                                    U64 length = mPacketData.size();
-                                    U64 data = 0;
-                                    for( unsigned i = 0; i < 8 && i < length; ++i )
-                                    {
-                                        data <<= 8;
-                                        data |= mPacketData[ i ];
-                                    }
-                                    AddFrame( data, length, kTypePacket, 0, mPacketDataStartingSample, endingSample );
-                                }
-                            }
-                            mPacketData.clear();
-                        }
-                        else if( value == kControlEep )
-                        {
-                            // error packet
-                            if( mPacketData.empty() )
-                            {
-                                mPacketDataStartingSample = startingSample;
-                            }
-                            if( mSettings->mShowErrorPackets )
-                            {
-                                U64 length = mPacketData.size();
-                                U64 data = 0;
-                                for( unsigned i = 0; i < 8 && i < length; ++i )
-                                {
-                                    data <<= 8;
-                                    data |= mPacketData[ i ];
-                                }
-                                AddFrame( data, length, kTypeErrorPacket, 0, mPacketDataStartingSample, endingSample );
-                            }
-                            mPacketData.clear();
-                        }
-                        else if( value == kControlFct )
-                        {
-                            // FCT (credit)
-                            if( mSettings->mShowFcts )
-                            {
-                                AddFrame( value, 0, kTypeControlCharacter, 0, startingSample, endingSample );
-                            }
-                        }
-                    }
-                    else
-                    {
-                        // save data
-                        if( mPacketData.empty() )
-                        {
-                            mPacketDataStartingSample = startingSample;
-                        }
-                        mPacketData.push_back( value );
-                    }
-                }
-            }
-        }
-        else
-        {
-            // report parity error
-            if( mSynchronized && mSettings->mShowErrors )
-            {
-                AddFrame( 0, 0, kTypeParityError, kFlagError, startingSample, endingSample );
-            }
-            if( mSettings->mDesyncAfterError )
-            {
-                mSynchronized = false;
-            }
-            if( mSynchronized )
-            {
-                mBits.Pop( charLength );
-            }
-            else
-            {
-                mBits.Pop( 2 );
-            }
-        }
-        ReportProgress( endingSample );
-    }
+void SpaceWireAnalyzer::ReportDecodeProgress( U64 sample )
+{
+    ReportProgress( sample );
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterSdkCalls );
 }
 
 bool SpaceWireAnalyzer::NeedsRerun()
@@ -406,8 +230,14 @@ U32 SpaceWireAnalyzer::GenerateSimulationData( U64 minimum_sample_index, U32 dev
 
 U32 SpaceWireAnalyzer::GetMinimumSampleRateHz()
 {
-    return 25000000;
-    // mSettings->mBitRate * 4;
+    // strict recovery needs the data and strobe edges of consecutive bits on different samples,
+    // tolerant recovery only needs the edges of each line on different samples
+    U64 linkRateBps = ( U64 )mSettings->mLinkRateMbps * 1000000;
+    if( mSettings->mBitRecovery == SpaceWireAnalyzerSettings::kRecoveryTolerant )
+    {
+        return ( U32 )( linkRateBps * 3 / 2 );
+    }
+    return ( U32 )( linkRateBps * 5 / 2 );
 }
 
 const char* SpaceWireAnalyzer::GetAnalyzerName() const
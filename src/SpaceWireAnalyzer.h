@@ -3,34 +3,16 @@
 #include <Analyzer.h>
 
 #include "SpaceWireAnalyzerResults.h"
+#include "SpaceWireBitStream.h"
+#include "SpaceWireCharacterStream.h"
+#include "SpaceWireCharacterTrace.h"
+#include "SpaceWireFrameBuilder.h"
+#include "SpaceWireInstrumentation.h"
 #include "SpaceWireSimulationDataGenerator.h"
 
-// holds up to 12 buffered bits
-struct BufferedBitsStruct
-{
-    // number of bits buffered
-    U16 count;
-    // value of those bits (LSB first)
-    U16 value;
-    // first sample of the given bit
-    U64 firstSample[ 6 ];
-    // constructor
-    BufferedBitsStruct();
-    // push a new bit into the buffer
-    // (can only be called when count < 12)
-    void Push( BitState state, U64 firstSampleOfBit );
-    // return the Xth bit in the buffer
-    U8 Get( U8 index ) const;
-    // return true if second parity bit matches
-    bool ParityMatch( unsigned int charLength ) const;
-    // pop an even number of characters
-    // (can only be called when count == 6 or count == 12)
-    void Pop( U8 skip );
-};
-
 class SpaceWireAnalyzerSettings;
 
-class ANALYZER_EXPORT SpaceWireAnalyzer : public Analyzer2
+class ANALYZER_EXPORT SpaceWireAnalyzer : public Analyzer2, public SpaceWireFrameSink
 {
 public:
 	SpaceWireAnalyzer();
@@ -67,12 +49,17 @@ public:
         kTypeEscapeError,
         kTypeParityError,
         kTypeLinkSpeedChange,
+        kTypeCreditError,
     };
 
     // frame flags
     enum FrameFlagEnum : uint8_t
     {
         kFlagNone = 0,
+        // timecode frame: bits 8..63 of mData1 hold the signed jitter in samples
+        kFlagJitter = 1 << 0,
+        // packet frame: the payload is an RMAP command or reply
+        kFlagRmap = 1 << 1,
         kFlagWarning = 1 << 6,
         kFlagError = 1 << 7,
     };
@@ -84,38 +71,66 @@ public:
 	std::auto_ptr< SpaceWireAnalyzerResults > mResults;
 	AnalyzerChannelData* mData;
     AnalyzerChannelData* mStrobe;
+    AnalyzerChannelData* mReverseData;
+    AnalyzerChannelData* mReverseStrobe;
+
+	// edge sources for the data and strobe channels
+    SpaceWireChannelEdgeSource mDataEdges;
+    SpaceWireChannelEdgeSource mStrobeEdges;
+	// merged data/strobe bit stream
+    SpaceWireBitStream mBitStream;
 
 	SpaceWireSimulationDataGenerator mSimulationDataGenerator;
 	bool mSimulationInitialized;
 
-	// desync the stream
-    void Desync();
-
-	// add a new frame
-    void AddFrame( U64 mData1, U64 mData2, U8 mType, U8 mFlags, U64 mStartingSampleInclusive, U64 mEndingSampleInclusive );
-
-	// true if stream is synchronized
-    bool mSynchronized;
-	// average bitrate (mbps) of last character
-    double mLastCharacterBitrateMbps;
-
-    // saved bits
-    BufferedBitsStruct mBits;
-
-	// current packet data buffer
-    std::vector<uint8_t> mPacketData;
-	// first sample of first bit of data buffer
-    U64 mPacketDataStartingSample;
-
-	// true if ESC code was immediately previous
-    bool mEscPrefix;
-	// first sample of previous ESC code
-    U64 mEscPrefixStartingSample;
-
-	// last timecode received, or 255 if none
-    U8 mLastTimecode;
-	// first bit of last timecode received
-    U64 mLastTimecodeStartingSample;
+	// return true if the recorded characters are those the current settings would decode
+    bool CanReplayTrace();
+
+	// return the first edge of the data and strobe channels (or of the end of the data) at the
+	// current position, which tells captures apart
+    void GetFirstEdges( U64 edges[ 2 ] );
+
+	// SpaceWireFrameSink, passing the frames on to mResults
+    virtual void AddFrame( const Frame& frame );
+    virtual void CommitFrames( const LinkStatisticsStruct& statistics, const TimecodeStatisticsStruct& timecodeStatistics );
+    virtual void CancelPacket();
+    virtual U64 CommitPacket( U64 handle, U64 length, U8 endMarker );
+    virtual U64 AddRmapTransaction( const RmapTransactionStruct& transaction );
+    virtual RmapTransactionStruct GetRmapTransaction( U64 transactionId );
+    virtual void SetRmapTransaction( U64 transactionId, const RmapTransactionStruct& transaction );
+    virtual void AddPacketToTransaction( U64 transactionId, U64 packetId );
+    virtual void ReportDecodeProgress( U64 sample );
+
+	// true if the reverse direction of the link is decoded as well
+    bool mHasReverse;
+	// characters of the reverse direction
+    SpaceWireCharacterStream mReverse;
+
+    // hot path counters and timers (only kept in instrumented builds)
+    SpaceWireInstrumentation mInstrumentation;
+    // decode loops and character to frame state, adding the frames through this
+    SpaceWireFrameBuilder mFrameBuilder;
+
+    // characters of the last full decode in both directions, so a change of display settings
+    // only has to rebuild the frames (only kept with mKeepCharacters set)
+    //
+    // this relies on Logic running WorkerThread again on the same analyzer object after a
+    // settings edit.  if it creates a new analyzer instead, the traces start out empty and the
+    // capture is decoded in full as usual.  a rerun without a settings edit always decodes in
+    // full, since new data can only be told from the edges.
+    SpaceWireCharacterTrace mTrace;
+    SpaceWireCharacterTrace mReverseTrace;
+    // true once a full decode has recorded the traces to the end of the data
+    bool mTraceComplete;
+    // what the traces were decoded from
+    Channel mTraceChannels[ 4 ];
+    U32 mTraceSampleRateHz;
+    U64 mTraceFirstSample;
+    U64 mTraceFirstEdges[ 2 ];
+    bool mTraceDesyncAfterError;
+    U64 mTracePairedEdgeSamples;
+    // settings edit count at the last decode
+    U32 mTraceEditCount;
 };
 
 extern "C" ANALYZER_EXPORT const char* __cdecl GetAnalyzerName();
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <iostream>
 #include <fstream>
 
@@ -10,6 +11,8 @@
 SpaceWireAnalyzerResults::SpaceWireAnalyzerResults( SpaceWireAnalyzer* analyzer, SpaceWireAnalyzerSettings* settings )
     : AnalyzerResults(), mSettings( settings ), mAnalyzer( analyzer )
 {
+    memset( &mLinkStatistics, 0, sizeof( mLinkStatistics ) );
+    memset( &mTimecodeStatistics, 0, sizeof( mTimecodeStatistics ) );
 }
 
 SpaceWireAnalyzerResults::~SpaceWireAnalyzerResults()
@@ -19,157 +22,489 @@ SpaceWireAnalyzerResults::~SpaceWireAnalyzerResults()
 void SpaceWireAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base )
 {
     ClearResultStrings();
-    Frame frame = GetFrame( frame_index );
 
-    static const char* controlType[ 4 ] = { "FCT", "EOP", "EEP", "ESC" };
-    static const char hexDigit[] = "0123456789ABCDEF";
+    // redraws ask for the same frames over and over, so only format frames not seen recently
+    const BubbleTextStruct* bubble = mBubbleCache.Find( frame_index );
+    if( bubble == NULL )
+    {
+        Frame frame = GetFrame( frame_index );
+        const U8* packetData = NULL;
+        PacketDigestStruct digestData;
+        const PacketDigestStruct* digest = NULL;
+        if( frame.mType == SpaceWireAnalyzer::kTypePacket || frame.mType == SpaceWireAnalyzer::kTypeErrorPacket )
+        {
+            packetData = mPacketArena.GetPacket( frame.mData1 );
+            digest = GetPacketDigest( frame, digestData );
+        }
+        BubbleTextStruct* entry = mBubbleCache.Insert( frame_index );
+        SpaceWireBubbleFormatter::Format( frame, packetData, digest, mAnalyzer->mSampleRateHz, *entry );
+        bubble = entry;
+    }
+
+    for( U32 i = 0; i < bubble->count; ++i )
+    {
+        AddResultString( bubble->text[ i ] );
+    }
+}
+
+/*
+
+pcapng export
+
+Each packet, error packet and timecode is one enhanced packet block on a single interface of link
+type LINKTYPE_USER0, with nanosecond timestamps counted from the start of the capture.  The
+packet data of each block is a one byte record type followed by the payload:
+
+0: packet ended by EOP (payload is the packet data)
+1: packet ended by EEP (payload is the packet data received before the EEP)
+2: timecode (payload is the 8-bit time value)
+
+*/
+
+// pcapng block types, link type and option codes
+static const U32 kPcapngSectionHeaderBlock = 0x0A0D0D0A;
+static const U32 kPcapngInterfaceBlock = 0x00000001;
+static const U32 kPcapngEnhancedPacketBlock = 0x00000006;
+static const U32 kPcapngByteOrderMagic = 0x1A2B3C4D;
+static const U16 kPcapngLinkTypeUser0 = 147;
+static const U16 kPcapngOptionEnd = 0;
+static const U16 kPcapngOptionIfName = 2;
+static const U16 kPcapngOptionIfTsresol = 9;
+
+// record types at the start of each pcapng packet
+enum PcapngRecordEnum : U8
+{
+    kRecordEop,
+    kRecordEep,
+    kRecordTimecode,
+};
 
-    if( frame.mType == SpaceWireAnalyzer::kTypeControlCharacter )
+void SpaceWireAnalyzerResults::GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id )
+{
+    if( export_type_user_id == SpaceWireAnalyzerSettings::kExportPcapng )
     {
-        AddResultString( controlType[ frame.mData1 & 0b11 ] );
+        ExportPcapng( file );
     }
-    else if( frame.mType == SpaceWireAnalyzer::kTypeDataCharacter )
+    else if( export_type_user_id == SpaceWireAnalyzerSettings::kExportStatistics )
     {
-        char buffer[ 5 ] = "0x00";
-        buffer[ 2 ] = hexDigit[ ( frame.mData1 & 0xF0 ) >> 4 ];
-        buffer[ 3 ] = hexDigit[ frame.mData1 & 0x0F ];
-        AddResultString( buffer );
+        ExportStatistics( file );
     }
-    else if( frame.mType == SpaceWireAnalyzer::kTypeNull )
+    else if( export_type_user_id == SpaceWireAnalyzerSettings::kExportTimecodes )
     {
-        AddResultString( "null" );
+        ExportTimecodes( file );
     }
-    else if( frame.mType == SpaceWireAnalyzer::kTypeTimecode )
+    else
+    {
+        ExportCsv( file, display_base );
+    }
+}
+
+void SpaceWireAnalyzerResults::ExportCsv( const char* file, DisplayBase display_base )
+{
+    if( !mExportWriter.Open( file ) )
     {
-        // calculate time since last timecode in us
-        char buffer[ 64 ] = { 0 };
-        if( frame.mFlags & SpaceWireAnalyzer ::kFlagWarning )
+        return;
+    }
+    mExportWriter.SetTimeBase( mAnalyzer->GetTriggerSample(), mAnalyzer->GetSampleRate() );
+    mExportWriter.Write( "Time [s],End [s],Type,Value,Length,Timecode delta [us],Status\n" );
+
+    U64 num_frames = GetNumFrames();
+    for( U64 i = 0; i < num_frames; i++ )
+    {
+        ExportFrame( GetFrame( i ), display_base );
+
+        // checking for cancel on every row would cost more than formatting it
+        if( ( i & 0xFFF ) == 0 && UpdateExportProgressAndCheckForCancel( i, num_frames ) == true )
         {
-            strcpy( &buffer[ strlen( buffer ) ], "unexpected " );
+            mExportWriter.Close();
+            return;
         }
-        sprintf( &buffer[strlen(buffer)], "timecode %u", ( unsigned int )frame.mData1 );
-        if( frame.mData2 )
+    }
+
+    UpdateExportProgressAndCheckForCancel( num_frames, num_frames );
+    mExportWriter.Close();
+}
+
+void SpaceWireAnalyzerResults::ExportPcapng( const char* file )
+{
+    if( !mExportWriter.Open( file ) )
+    {
+        return;
+    }
+
+    // section header block (section length unknown)
+    mExportWriter.WriteU32( kPcapngSectionHeaderBlock );
+    mExportWriter.WriteU32( 28 );
+    mExportWriter.WriteU32( kPcapngByteOrderMagic );
+    mExportWriter.WriteU16( 1 );
+    mExportWriter.WriteU16( 0 );
+    mExportWriter.WriteU32( 0xFFFFFFFF );
+    mExportWriter.WriteU32( 0xFFFFFFFF );
+    mExportWriter.WriteU32( 28 );
+
+    // interface description block with the interface name and nanosecond timestamps
+    static const char name[] = "SpaceWire";
+    mExportWriter.WriteU32( kPcapngInterfaceBlock );
+    mExportWriter.WriteU32( 48 );
+    mExportWriter.WriteU16( kPcapngLinkTypeUser0 );
+    mExportWriter.WriteU16( 0 );
+    mExportWriter.WriteU32( 0 );
+    mExportWriter.WriteU16( kPcapngOptionIfName );
+    mExportWriter.WriteU16( sizeof( name ) - 1 );
+    mExportWriter.WriteBytes( name, sizeof( name ) - 1 );
+    mExportWriter.WriteBytes( "\0\0\0", 3 );
+    mExportWriter.WriteU16( kPcapngOptionIfTsresol );
+    mExportWriter.WriteU16( 1 );
+    mExportWriter.WriteBytes( "\x09\0\0\0", 4 );
+    mExportWriter.WriteU16( kPcapngOptionEnd );
+    mExportWriter.WriteU16( 0 );
+    mExportWriter.WriteU32( 48 );
+
+    U64 num_frames = GetNumFrames();
+    for( U64 i = 0; i < num_frames; i++ )
+    {
+        Frame frame = GetFrame( i );
+        if( frame.mType == SpaceWireAnalyzer::kTypePacket || frame.mType == SpaceWireAnalyzer::kTypeErrorPacket )
         {
-            double delta = frame.mData2 / ( mAnalyzer->mSampleRateHz / 1e6 );
-            sprintf( &buffer[ strlen( buffer ) ], " (delta=%g us)", delta );
+            U8 recordType = ( frame.mType == SpaceWireAnalyzer::kTypePacket ) ? kRecordEop : kRecordEep;
+            // packets whose middle wasn't kept are written as captures of their head only
+            U64 stored = mPacketArena.GetStoredLength( frame.mData2 );
+            U32 captured = ( U32 )( ( stored == frame.mData2 ) ? stored : SpaceWirePacketArena::kHeadBytes );
+            ExportPcapngRecord( frame.mStartingSampleInclusive, recordType, mPacketArena.GetPacket( frame.mData1 ), captured,
+                                ( U32 )frame.mData2 );
+        }
+        else if( frame.mType == SpaceWireAnalyzer::kTypeEmptyPacket )
+        {
+            ExportPcapngRecord( frame.mStartingSampleInclusive, kRecordEop, NULL, 0, 0 );
+        }
+        else if( frame.mType == SpaceWireAnalyzer::kTypeTimecode )
+        {
+            U8 value = ( U8 )frame.mData1;
+            ExportPcapngRecord( frame.mStartingSampleInclusive, kRecordTimecode, &value, 1, 1 );
+        }
+
+        if( ( i & 0xFFF ) == 0 && UpdateExportProgressAndCheckForCancel( i, num_frames ) == true )
+        {
+            mExportWriter.Close();
+            return;
         }
-        AddResultString( buffer );
     }
-    else if( frame.mType == SpaceWireAnalyzer::kTypePacket )
+
+    UpdateExportProgressAndCheckForCancel( num_frames, num_frames );
+    mExportWriter.Close();
+}
+
+void SpaceWireAnalyzerResults::ExportStatistics( const char* file )
+{
+    if( !mExportWriter.Open( file ) )
+    {
+        return;
+    }
+    SpaceWireLinkStatistics::WriteReport( GetLinkStatistics(), mAnalyzer->GetSampleRate(), mExportWriter );
+    mExportWriter.Close();
+}
+
+void SpaceWireAnalyzerResults::ExportTimecodes( const char* file )
+{
+    if( !mExportWriter.Open( file ) )
+    {
+        return;
+    }
+    SpaceWireTimecodeStatistics::WriteReport( GetTimecodeStatistics(), mAnalyzer->GetSampleRate(), mExportWriter );
+    mExportWriter.Close();
+}
+
+void SpaceWireAnalyzerResults::ExportPcapngRecord( S64 sample, U8 recordType, const U8* data, U32 length, U32 originalLength )
+{
+    // timestamp in ns from the start of the capture, split so the multiplication cannot overflow
+    U64 rate = mAnalyzer->GetSampleRate();
+    U64 position = ( sample > 0 ) ? sample : 0;
+    U64 timestamp = ( position / rate ) * 1000000000ULL + ( position % rate ) * 1000000000ULL / rate;
+
+    // packet data is the record type and payload, padded to 32 bits
+    U32 captured = length + 1;
+    U32 padding = ( 4 - ( captured & 3 ) ) & 3;
+    U32 blockLength = 32 + captured + padding;
+
+    mExportWriter.WriteU32( kPcapngEnhancedPacketBlock );
+    mExportWriter.WriteU32( blockLength );
+    mExportWriter.WriteU32( 0 );
+    mExportWriter.WriteU32( ( U32 )( timestamp >> 32 ) );
+    mExportWriter.WriteU32( ( U32 )timestamp );
+    mExportWriter.WriteU32( captured );
+    mExportWriter.WriteU32( originalLength + 1 );
+    mExportWriter.WriteBytes( &recordType, 1 );
+    mExportWriter.WriteBytes( data, length );
+    mExportWriter.WriteBytes( "\0\0\0", padding );
+    mExportWriter.WriteU32( blockLength );
+}
+
+void SpaceWireAnalyzerResults::ExportFrame( const Frame& frame, DisplayBase display_base )
+{
+    static const char* controlType[ 4 ] = { "FCT", "EOP", "EEP", "ESC" };
+
+    mExportWriter.WriteTime( frame.mStartingSampleInclusive );
+    mExportWriter.WriteChar( ',' );
+    mExportWriter.WriteTime( frame.mEndingSampleInclusive );
+    mExportWriter.WriteChar( ',' );
+
+    // type, value, length and timecode delta columns
+    switch( frame.mType )
     {
-        char buffer[ 64 ] = { 0 };
-        char* ptr = buffer;
-        if( frame.mData2 < 8 )
+    case SpaceWireAnalyzer::kTypeControlCharacter:
+        mExportWriter.Write( "control," );
+        mExportWriter.Write( controlType[ frame.mData1 & 0b11 ] );
+        mExportWriter.WriteChar( ',' );
+        // the length of a collapsed run is its number of characters
+        if( frame.mData2 != 0 )
         {
-            frame.mData1 <<= 8 * ( 8 - frame.mData2 );
+            mExportWriter.WriteUnsigned( frame.mData2 );
         }
-        for( unsigned int i = 0; i < frame.mData2 && i < 8; ++i )
+        mExportWriter.WriteChar( ',' );
+        break;
+    case SpaceWireAnalyzer::kTypeDataCharacter:
+        mExportWriter.Write( "data," );
+        ExportValue( ( U8 )frame.mData1, display_base );
+        mExportWriter.Write( ",," );
+        break;
+    case SpaceWireAnalyzer::kTypeNull:
+        mExportWriter.Write( "null,," );
+        if( frame.mData2 != 0 )
         {
-            *ptr++ = hexDigit[ frame.mData1 >> 60 ];
-            frame.mData1 <<= 4;
-            *ptr++ = hexDigit[ frame.mData1 >> 60 ];
-            frame.mData1 <<= 4;
+            mExportWriter.WriteUnsigned( frame.mData2 );
         }
-        if( frame.mData2 > 8 )
+        mExportWriter.WriteChar( ',' );
+        break;
+    case SpaceWireAnalyzer::kTypeTimecode:
+        mExportWriter.Write( "timecode," );
+        ExportValue( ( U8 )frame.mData1, display_base );
+        mExportWriter.Write( ",," );
+        if( frame.mData2 )
         {
-            sprintf( ptr, " (%u bytes total)", ( unsigned int )frame.mData2 );
+            // delta in ns, split so the multiplication cannot overflow
+            U32 rate = mAnalyzer->GetSampleRate();
+            U64 ns = ( frame.mData2 / rate ) * 1000000000ULL + ( frame.mData2 % rate ) * 1000000000ULL / rate;
+            mExportWriter.WriteUnsigned( ns / 1000 );
+            mExportWriter.WriteChar( '.' );
+            mExportWriter.WritePadded( ns % 1000, 3 );
         }
-        AddResultString( buffer );
-    }
-    else if( frame.mType == SpaceWireAnalyzer::kTypeEmptyPacket )
+        break;
+    case SpaceWireAnalyzer::kTypePacket:
+    case SpaceWireAnalyzer::kTypeErrorPacket:
     {
-        AddResultString( "empty packet" );
+        mExportWriter.Write( ( frame.mType == SpaceWireAnalyzer::kTypePacket ) ? "packet," : "error packet," );
+        const U8* data = mPacketArena.GetPacket( frame.mData1 );
+        U64 stored = mPacketArena.GetStoredLength( frame.mData2 );
+        if( stored == frame.mData2 )
+        {
+            mExportWriter.WriteHexBytes( data, frame.mData2 );
+        }
+        else
+        {
+            // only the head and tail were kept
+            mExportWriter.WriteHexBytes( data, SpaceWirePacketArena::kHeadBytes );
+            mExportWriter.Write( "..." );
+            mExportWriter.WriteHexBytes( data + SpaceWirePacketArena::kHeadBytes, stored - SpaceWirePacketArena::kHeadBytes );
+        }
+        mExportWriter.WriteChar( ',' );
+        mExportWriter.WriteUnsigned( frame.mData2 );
+        mExportWriter.WriteChar( ',' );
+        break;
+    }
+    case SpaceWireAnalyzer::kTypeEmptyPacket:
+        mExportWriter.Write( "empty packet,,0," );
+        break;
+    case SpaceWireAnalyzer::kTypeEscapeError:
+        mExportWriter.Write( "escape error,,," );
+        break;
+    case SpaceWireAnalyzer::kTypeParityError:
+        mExportWriter.Write( "parity error,,," );
+        break;
+    case SpaceWireAnalyzer::kTypeLinkSpeedChange:
+        mExportWriter.Write( "link speed change," );
+        mExportWriter.WriteUnsigned( frame.mData1 );
+        mExportWriter.Write( ",," );
+        break;
+    case SpaceWireAnalyzer::kTypeCreditError:
+        mExportWriter.Write( ( frame.mData1 == SpaceWireCreditTracker::kEventOverflow ) ? "credit overflow," : "credit underflow," );
+        mExportWriter.Write( ( frame.mData2 == SpaceWireCreditTracker::kDirectionReverse ) ? "reverse,," : "forward,," );
+        break;
+    default:
+        mExportWriter.Write( "UNKNOWN,,," );
+        break;
     }
-    else if( frame.mType == SpaceWireAnalyzer::kTypeErrorPacket )
+
+    mExportWriter.WriteChar( ',' );
+    if( frame.mFlags & SpaceWireAnalyzer::kFlagError )
     {
-        AddResultString( "error packet" );
+        mExportWriter.Write( "error" );
     }
-    else if( frame.mType == SpaceWireAnalyzer::kTypeEscapeError )
+    else if( frame.mFlags & SpaceWireAnalyzer::kFlagWarning )
     {
-        AddResultString( "escape error" );
+        mExportWriter.Write( "warning" );
     }
-    else if( frame.mType == SpaceWireAnalyzer::kTypeParityError )
+    mExportWriter.WriteChar( '\n' );
+}
+
+void SpaceWireAnalyzerResults::ExportValue( U8 value, DisplayBase display_base )
+{
+    switch( display_base )
     {
-        AddResultString( "parity error" );
+    case Decimal:
+        mExportWriter.WriteUnsigned( value );
+        break;
+    case Binary:
+        mExportWriter.Write( "0b" );
+        mExportWriter.WriteBinary( value, 8 );
+        break;
+    case ASCII:
+        if( value >= 0x20 && value < 0x7F && value != ',' && value != '"' )
+        {
+            mExportWriter.WriteChar( ( char )value );
+            break;
+        }
+        // non-printable characters fall back to hex
+    default:
+        mExportWriter.Write( "0x" );
+        mExportWriter.WriteHex( value, 2 );
+        break;
     }
-    else
+}
+
+void SpaceWireAnalyzerResults::GenerateFrameTabularText( U64 frame_index, DisplayBase display_base )
+{
+    ClearTabularText();
+    Frame frame = GetFrame( frame_index );
+
+    const U8* packetData = NULL;
+    PacketDigestStruct digestData;
+    const PacketDigestStruct* digest = NULL;
+    if( frame.mType == SpaceWireAnalyzer::kTypePacket || frame.mType == SpaceWireAnalyzer::kTypeErrorPacket )
     {
-        AddResultString( "UNKNOWN" );
+        packetData = mPacketArena.GetPacket( frame.mData1 );
+        digest = GetPacketDigest( frame, digestData );
     }
 
-    // char number_str[ 128 ];
-    // AnalyzerHelpers::GetNumberString( frame.mData1, display_base, 8, number_str, 128 );
-    // AddResultString( number_str );
+    char text[ BubbleTextStruct::kMaxLength ];
+    SpaceWireBubbleFormatter::FormatTabular( frame, packetData, digest, mAnalyzer->mSampleRateHz, text );
+    AddTabularText( text );
 }
 
-void SpaceWireAnalyzerResults::GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id )
+void SpaceWireAnalyzerResults::GeneratePacketTabularText( U64 packet_id, DisplayBase display_base )
 {
-    // std::ofstream file_stream( file, std::ios::out );
+    ClearTabularText();
 
-    // U64 trigger_sample = mAnalyzer->GetTriggerSample();
-    // U32 sample_rate = mAnalyzer->GetSampleRate();
+    // summarize the packet from its recorded payload instead of walking its character frames
+    Frame frame;
+    {
+        std::lock_guard<std::mutex> lock( mPacketSummariesMutex );
+        if( packet_id >= mPacketSummaries.size() )
+        {
+            return;
+        }
+        const PacketSummaryStruct& summary = mPacketSummaries[ packet_id ];
+        frame.mType = ( summary.endMarker == SpaceWireAnalyzer::kControlEop ) ? SpaceWireAnalyzer::kTypePacket
+                                                                                : SpaceWireAnalyzer::kTypeErrorPacket;
+        frame.mData1 = summary.handle;
+        frame.mData2 = summary.length;
+    }
 
-    // file_stream << "Time [s],Value" << std::endl;
+    PacketDigestStruct digestData;
+    const PacketDigestStruct* digest = GetPacketDigest( frame, digestData );
+    char text[ BubbleTextStruct::kMaxLength ];
+    SpaceWireBubbleFormatter::FormatTabular( frame, mPacketArena.GetPacket( frame.mData1 ), digest, mAnalyzer->mSampleRateHz, text );
+    AddTabularText( text );
+}
 
-    // U64 num_frames = GetNumFrames();
-    // for( U32 i = 0; i < num_frames; i++ )
-    //{
-    //    Frame frame = GetFrame( i );
+void SpaceWireAnalyzerResults::AddPacketSummary( U64 packet_id, U64 handle, U64 length, U8 end_marker )
+{
+    PacketSummaryStruct summary;
+    summary.handle = handle;
+    summary.length = length;
+    summary.endMarker = end_marker;
 
-    //    char time_str[ 128 ];
-    //    AnalyzerHelpers::GetTimeString( frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128 );
+    // packet ids are handed out in order, so this normally just appends
+    std::lock_guard<std::mutex> lock( mPacketSummariesMutex );
+    if( packet_id >= mPacketSummaries.size() )
+    {
+        mPacketSummaries.resize( packet_id + 1 );
+    }
+    mPacketSummaries[ packet_id ] = summary;
+}
 
-    //    char number_str[ 128 ];
-    //    AnalyzerHelpers::GetNumberString( frame.mData1, display_base, 8, number_str, 128 );
+const PacketDigestStruct* SpaceWireAnalyzerResults::GetPacketDigest( const Frame& frame, PacketDigestStruct& digest )
+{
+    if( !mPacketArena.IsDigestMode() )
+    {
+        return NULL;
+    }
+    mPacketArena.GetDigest( frame.mData1, frame.mData2, digest );
+    return &digest;
+}
 
-    //    file_stream << time_str << "," << number_str << std::endl;
+SpaceWirePacketArena& SpaceWireAnalyzerResults::GetPacketArena()
+{
+    return mPacketArena;
+}
 
-    //    if( UpdateExportProgressAndCheckForCancel( i, num_frames ) == true )
-    //    {
-    //        file_stream.close();
-    //        return;
-    //    }
-    //}
+void SpaceWireAnalyzerResults::SetLinkStatistics( const LinkStatisticsStruct& statistics )
+{
+    std::lock_guard<std::mutex> lock( mLinkStatisticsMutex );
+    mLinkStatistics = statistics;
+}
 
-    // file_stream.close();
+LinkStatisticsStruct SpaceWireAnalyzerResults::GetLinkStatistics()
+{
+    std::lock_guard<std::mutex> lock( mLinkStatisticsMutex );
+    return mLinkStatistics;
 }
 
-void SpaceWireAnalyzerResults::GenerateFrameTabularText( U64 frame_index, DisplayBase display_base )
+void SpaceWireAnalyzerResults::SetTimecodeStatistics( const TimecodeStatisticsStruct& statistics )
 {
-    ClearTabularText();
-    Frame frame = GetFrame( frame_index );
+    std::lock_guard<std::mutex> lock( mTimecodeStatisticsMutex );
+    mTimecodeStatistics = statistics;
+}
 
-    static const char* controlType[ 4 ] = { "FCT", "EOP", "EEP", "ESC" };
+TimecodeStatisticsStruct SpaceWireAnalyzerResults::GetTimecodeStatistics()
+{
+    std::lock_guard<std::mutex> lock( mTimecodeStatisticsMutex );
+    return mTimecodeStatistics;
+}
 
-    if( frame.mType == 0 )
-    {
-        AddTabularText( controlType[ frame.mData1 & 0b11 ] );
-    }
-    else
+void SpaceWireAnalyzerResults::GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base )
+{
+    ClearTabularText();
+
+    RmapTransactionStruct transaction;
     {
-        char buffer[ 5 ] = "0x00";
-        static const char hexDigit[] = "0123456789ABCDEF";
-        buffer[ 2 ] = hexDigit[ ( frame.mData1 & 0xF0 ) >> 4 ];
-        buffer[ 3 ] = hexDigit[ frame.mData1 & 0x0F ];
-        AddTabularText( buffer );
+        std::lock_guard<std::mutex> lock( mRmapTransactionsMutex );
+        if( transaction_id >= mRmapTransactions.size() )
+        {
+            return;
+        }
+        transaction = mRmapTransactions[ transaction_id ];
     }
 
-    //#ifdef SUPPORTS_PROTOCOL_SEARCH
-    //    Frame frame = GetFrame( frame_index );
-    //    ClearTabularText();
-    //
-    //    char number_str[ 128 ];
-    //    AnalyzerHelpers::GetNumberString( frame.mData1, display_base, 8, number_str, 128 );
-    //    AddTabularText( number_str );
-    //#endif
+    char text[ BubbleTextStruct::kMaxLength ];
+    SpaceWireBubbleFormatter::FormatTransaction( transaction, mAnalyzer->mSampleRateHz, text );
+    AddTabularText( text );
 }
 
-void SpaceWireAnalyzerResults::GeneratePacketTabularText( U64 packet_id, DisplayBase display_base )
+U64 SpaceWireAnalyzerResults::AddRmapTransaction( const RmapTransactionStruct& transaction )
 {
-    // not supported
+    std::lock_guard<std::mutex> lock( mRmapTransactionsMutex );
+    mRmapTransactions.push_back( transaction );
+    return mRmapTransactions.size() - 1;
 }
 
-void SpaceWireAnalyzerResults::GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base )
+RmapTransactionStruct SpaceWireAnalyzerResults::GetRmapTransaction( U64 transaction_id )
+{
+    std::lock_guard<std::mutex> lock( mRmapTransactionsMutex );
+    return mRmapTransactions[ transaction_id ];
+}
+
+void SpaceWireAnalyzerResults::SetRmapTransaction( U64 transaction_id, const RmapTransactionStruct& transaction )
 {
-    // not supported
+    std::lock_guard<std::mutex> lock( mRmapTransactionsMutex );
+    mRmapTransactions[ transaction_id ] = transaction;
 }
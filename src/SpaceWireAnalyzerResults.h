@@ -1,7 +1,17 @@
 #pragma once
 
+#include <mutex>
+#include <vector>
+
 #include <AnalyzerResults.h>
 
+#include "SpaceWireBubbleText.h"
+#include "SpaceWireExportWriter.h"
+#include "SpaceWireLinkStatistics.h"
+#include "SpaceWirePacketArena.h"
+#include "SpaceWireRmap.h"
+#include "SpaceWireTimecodeStatistics.h"
+
 class SpaceWireAnalyzer;
 class SpaceWireAnalyzerSettings;
 
@@ -18,9 +28,72 @@ public:
 	virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base );
 	virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base );
 
+	// payloads of all packet frames (mData1 is the handle, mData2 the length)
+	SpaceWirePacketArena& GetPacketArena();
+	// record the payload of an sdk packet for the packet table
+	void AddPacketSummary( U64 packet_id, U64 handle, U64 length, U8 end_marker );
+
+	// replace the link statistics (called by the analyzer as results are committed)
+	void SetLinkStatistics( const LinkStatisticsStruct& statistics );
+	// return the link statistics of the committed results
+	LinkStatisticsStruct GetLinkStatistics();
+
+	// replace the timecode statistics (called by the analyzer as results are committed)
+	void SetTimecodeStatistics( const TimecodeStatisticsStruct& statistics );
+	// return the timecode statistics of the committed results
+	TimecodeStatisticsStruct GetTimecodeStatistics();
+
+	// add an RMAP transaction and return its sdk transaction id
+	U64 AddRmapTransaction( const RmapTransactionStruct& transaction );
+	// return or replace an RMAP transaction
+	RmapTransactionStruct GetRmapTransaction( U64 transaction_id );
+	void SetRmapTransaction( U64 transaction_id, const RmapTransactionStruct& transaction );
+
 protected: //functions
+	// write all frames as csv
+	void ExportCsv( const char* file, DisplayBase display_base );
+	// write packets and timecodes as pcapng
+	void ExportPcapng( const char* file );
+	// write the link statistics report
+	void ExportStatistics( const char* file );
+	// write the timecode period and jitter report
+	void ExportTimecodes( const char* file );
+	// write one packet or timecode as a pcapng enhanced packet block
+	// (length bytes of data are captured, of a payload originalLength bytes long)
+	void ExportPcapngRecord( S64 sample, U8 recordType, const U8* data, U32 length, U32 originalLength );
+	// write one frame as a csv row
+	void ExportFrame( const Frame& frame, DisplayBase display_base );
+	// write a character value in the given display base
+	void ExportValue( U8 value, DisplayBase display_base );
+	// return the digest of a packet frame if only its head and tail were kept, NULL otherwise
+	const PacketDigestStruct* GetPacketDigest( const Frame& frame, PacketDigestStruct& digest );
 
 protected:  //vars
+	// payload and end marker of an sdk packet
+	struct PacketSummaryStruct
+	{
+		U64 handle;
+		U64 length;
+		U8 endMarker;
+	};
+
 	SpaceWireAnalyzerSettings* mSettings;
 	SpaceWireAnalyzer* mAnalyzer;
+	SpaceWirePacketArena mPacketArena;
+	// summaries indexed by sdk packet id (guarded by mPacketSummariesMutex)
+	std::vector<PacketSummaryStruct> mPacketSummaries;
+	std::mutex mPacketSummariesMutex;
+	// RMAP transactions indexed by sdk transaction id (guarded by mRmapTransactionsMutex)
+	std::vector<RmapTransactionStruct> mRmapTransactions;
+	std::mutex mRmapTransactionsMutex;
+	// recently formatted bubble text
+	SpaceWireBubbleCache mBubbleCache;
+	// link statistics (guarded by mLinkStatisticsMutex)
+	LinkStatisticsStruct mLinkStatistics;
+	std::mutex mLinkStatisticsMutex;
+	// timecode statistics (guarded by mTimecodeStatisticsMutex)
+	TimecodeStatisticsStruct mTimecodeStatistics;
+	std::mutex mTimecodeStatisticsMutex;
+	// export output (its buffer is reused between exports)
+	SpaceWireExportWriter mExportWriter;
 };
@@ -1,19 +1,39 @@
 #include "SpaceWireAnalyzerSettings.h"
+#include "SpaceWireSimulationDataGenerator.h"
 #include <AnalyzerHelpers.h>
 
 
 SpaceWireAnalyzerSettings::SpaceWireAnalyzerSettings()
     : mDataChannel( UNDEFINED_CHANNEL ),
       mStrobeChannel( UNDEFINED_CHANNEL ),
+      mReverseDataChannel( UNDEFINED_CHANNEL ),
+      mReverseStrobeChannel( UNDEFINED_CHANNEL ),
       mCombineChars( true ),
       mShowNulls( false ),
       mShowFcts( false ),
+      mCollapseRuns( true ),
       mShowTimecodes( true ),
       mShowRegularPackets( true ),
       mShowErrorPackets( true ),
       mShowErrors( true ),
       mShowLinkSpeedChanges( false ),
-      mDesyncAfterError( true )
+      mShowTimecodeJitter( false ),
+      mDecodeRmap( true ),
+      mDesyncAfterError( true ),
+      mLinkRateMbps( 10 ),
+      mBitRecovery( kRecoveryStrict ),
+      mDecodeMode( kDecodeSingleThread ),
+      mPayloadMode( kPayloadFull ),
+      mKeepCharacters( false ),
+      mSimulationRateMbps( 10 ),
+      mSimulationPackets( kPacketsMixed ),
+      mSimulationNulls( 4 ),
+      mSimulationTimecodePeriodUs( 100 ),
+      mSimulationSeed( 1 ),
+      mSimulationFaults( kFaultsNone ),
+      mSimulationFaultKind( SimulationTrafficStruct::kFaultCount ),
+      mSimulationFaultSeed( 1 ),
+      mEditCount( 0 )
 {
     mDataChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
     mDataChannelInterface->SetTitleAndTooltip( "Data", "Data channel" );
@@ -23,6 +43,16 @@ SpaceWireAnalyzerSettings::SpaceWireAnalyzerSettings()
     mStrobeChannelInterface->SetTitleAndTooltip( "Strobe", "Strobe channel" );
     mStrobeChannelInterface->SetChannel( mStrobeChannel );
 
+    mReverseDataChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
+    mReverseDataChannelInterface->SetTitleAndTooltip( "Reverse Data", "Data channel of the other direction (for FCT credit tracking)" );
+    mReverseDataChannelInterface->SetChannel( mReverseDataChannel );
+    mReverseDataChannelInterface->SetSelectionOfNoneIsAllowed( true );
+
+    mReverseStrobeChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
+    mReverseStrobeChannelInterface->SetTitleAndTooltip( "Reverse Strobe", "Strobe channel of the other direction (for FCT credit tracking)" );
+    mReverseStrobeChannelInterface->SetChannel( mReverseStrobeChannel );
+    mReverseStrobeChannelInterface->SetSelectionOfNoneIsAllowed( true );
+
     mCombineCharsInterface.reset( new AnalyzerSettingInterfaceBool() );
     mCombineCharsInterface->SetTitleAndTooltip( "", "Show packets and codes rather than bare characters" );
     mCombineCharsInterface->SetCheckBoxText( "Combine characters" );
@@ -38,6 +68,11 @@ SpaceWireAnalyzerSettings::SpaceWireAnalyzerSettings()
     mShowFctsInterface->SetCheckBoxText( "Show FCTs" );
     mShowFctsInterface->SetValue( mShowFcts );
 
+    mCollapseRunsInterface.reset( new AnalyzerSettingInterfaceBool() );
+    mCollapseRunsInterface->SetTitleAndTooltip( "", "Show each run of back-to-back NULLs or FCTs as a single frame" );
+    mCollapseRunsInterface->SetCheckBoxText( "Collapse NULL/FCT runs" );
+    mCollapseRunsInterface->SetValue( mCollapseRuns );
+
     mShowTimecodesInterface.reset( new AnalyzerSettingInterfaceBool() );
     mShowTimecodesInterface->SetTitleAndTooltip( "", "" );
     mShowTimecodesInterface->SetCheckBoxText( "Show time-codes" );
@@ -63,30 +98,175 @@ SpaceWireAnalyzerSettings::SpaceWireAnalyzerSettings()
     mShowLinkSpeedChangesInterface->SetCheckBoxText( "Show link speed changes" );
     mShowLinkSpeedChangesInterface->SetValue( mShowLinkSpeedChanges );
 
+    mShowTimecodeJitterInterface.reset( new AnalyzerSettingInterfaceBool() );
+    mShowTimecodeJitterInterface->SetTitleAndTooltip( "", "Annotate each time-code with its period minus the reference period" );
+    mShowTimecodeJitterInterface->SetCheckBoxText( "Show time-code jitter" );
+    mShowTimecodeJitterInterface->SetValue( mShowTimecodeJitter );
+
+    mDecodeRmapInterface.reset( new AnalyzerSettingInterfaceBool() );
+    mDecodeRmapInterface->SetTitleAndTooltip( "", "Decode packets with protocol identifier 1 as RMAP and pair commands with replies" );
+    mDecodeRmapInterface->SetCheckBoxText( "Decode RMAP" );
+    mDecodeRmapInterface->SetValue( mDecodeRmap );
+
     mDesyncAfterErrorInterface.reset( new AnalyzerSettingInterfaceBool() );
     mDesyncAfterErrorInterface->SetTitleAndTooltip( "", "" );
     mDesyncAfterErrorInterface->SetCheckBoxText( "Desync after protocol error" );
     mDesyncAfterErrorInterface->SetValue( mDesyncAfterError );
 
+    mLinkRateInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mLinkRateInterface->SetTitleAndTooltip( "Link rate", "Highest bit rate expected on the link, which sets the minimum sample rate" );
+    mLinkRateInterface->AddNumber( 10, "10 Mbit/s", "" );
+    mLinkRateInterface->AddNumber( 50, "50 Mbit/s", "" );
+    mLinkRateInterface->AddNumber( 100, "100 Mbit/s", "" );
+    mLinkRateInterface->AddNumber( 200, "200 Mbit/s", "" );
+    mLinkRateInterface->AddNumber( 400, "400 Mbit/s", "" );
+    mLinkRateInterface->SetNumber( mLinkRateMbps );
+
+    mBitRecoveryInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mBitRecoveryInterface->SetTitleAndTooltip( "Bit recovery", "How data and strobe changing on the same sample are handled" );
+    mBitRecoveryInterface->AddNumber( kRecoveryStrict, "Strict", "Lose sync (needs 2.5 samples per bit at the link rate)" );
+    mBitRecoveryInterface->AddNumber( kRecoveryTolerant, "Tolerant",
+                                      "Take them as two bits and settle their order with the parity check (needs 1.5 samples per bit)" );
+    mBitRecoveryInterface->SetNumber( mBitRecovery );
+
+    mDecodeModeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mDecodeModeInterface->SetTitleAndTooltip( "Decoding", "How decoding is spread across threads" );
+    mDecodeModeInterface->AddNumber( kDecodeSingleThread, "Single thread", "Decode on the analyzer thread only" );
+    mDecodeModeInterface->AddNumber( kDecodePipelined, "Pipelined",
+                                     "Decode characters on a separate thread while edges are read and frames emitted" );
+    mDecodeModeInterface->AddNumber( kDecodeSegmented, "Segmented", "Decode segments of the capture on all available cores" );
+    mDecodeModeInterface->SetNumber( mDecodeMode );
+
+    mPayloadModeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mPayloadModeInterface->SetTitleAndTooltip( "Packet payload", "How much of each packet is kept for display and export" );
+    mPayloadModeInterface->AddNumber( kPayloadFull, "Keep whole packets", "Keep every byte of every packet" );
+    mPayloadModeInterface->AddNumber( kPayloadDigest, "Keep head and tail only",
+                                      "Keep the first and last 64 bytes and a CRC-32 of each packet, for captures of very large packets" );
+    mPayloadModeInterface->SetNumber( mPayloadMode );
+
+    mKeepCharactersInterface.reset( new AnalyzerSettingInterfaceBool() );
+    mKeepCharactersInterface->SetTitleAndTooltip(
+        "", "Keep up to 128 MiB of decoded characters, so changing only display settings rebuilds the frames without decoding again" );
+    mKeepCharactersInterface->SetCheckBoxText( "Keep decoded characters" );
+    mKeepCharactersInterface->SetValue( mKeepCharacters );
+
+    mSimulationRateInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mSimulationRateInterface->SetTitleAndTooltip( "Simulated link rate",
+                                                  "Bit rate of simulated data after the 10 Mbit/s start-up (limited to half the sample rate)" );
+    mSimulationRateInterface->AddNumber( 10, "10 Mbit/s", "" );
+    mSimulationRateInterface->AddNumber( 50, "50 Mbit/s", "" );
+    mSimulationRateInterface->AddNumber( 100, "100 Mbit/s", "" );
+    mSimulationRateInterface->AddNumber( 200, "200 Mbit/s", "" );
+    mSimulationRateInterface->AddNumber( 400, "400 Mbit/s", "" );
+    mSimulationRateInterface->SetNumber( mSimulationRateMbps );
+
+    mSimulationPacketsInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mSimulationPacketsInterface->SetTitleAndTooltip( "Simulated packets",
+                                                     "Lengths of simulated packets, spread evenly over the powers of two in the range" );
+    mSimulationPacketsInterface->AddNumber( kPacketsSmall, "4 to 64 bytes", "" );
+    mSimulationPacketsInterface->AddNumber( kPacketsMixed, "4 to 1024 bytes", "" );
+    mSimulationPacketsInterface->AddNumber( kPacketsLarge, "1 KiB to 64 KiB", "" );
+    mSimulationPacketsInterface->SetNumber( mSimulationPackets );
+
+    mSimulationNullsInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mSimulationNullsInterface->SetTitleAndTooltip( "Simulated NULL fill", "NULLs sent between simulated packets" );
+    mSimulationNullsInterface->AddNumber( 0, "None", "Packets back to back" );
+    mSimulationNullsInterface->AddNumber( 4, "4 NULLs", "" );
+    mSimulationNullsInterface->AddNumber( 16, "16 NULLs", "" );
+    mSimulationNullsInterface->AddNumber( 64, "64 NULLs", "" );
+    mSimulationNullsInterface->AddNumber( 256, "256 NULLs", "" );
+    mSimulationNullsInterface->SetNumber( mSimulationNulls );
+
+    mSimulationTimecodeInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mSimulationTimecodeInterface->SetTitleAndTooltip( "Simulated time-codes", "Period of simulated time-codes" );
+    mSimulationTimecodeInterface->AddNumber( 0, "None", "" );
+    mSimulationTimecodeInterface->AddNumber( 10, "Every 10 us", "" );
+    mSimulationTimecodeInterface->AddNumber( 100, "Every 100 us", "" );
+    mSimulationTimecodeInterface->AddNumber( 1000, "Every 1 ms", "" );
+    mSimulationTimecodeInterface->AddNumber( 10000, "Every 10 ms", "" );
+    mSimulationTimecodeInterface->SetNumber( mSimulationTimecodePeriodUs );
+
+    mSimulationSeedInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mSimulationSeedInterface->SetTitleAndTooltip( "Simulation seed", "Seed of the random packet lengths of simulated data" );
+    mSimulationSeedInterface->SetMin( 1 );
+    mSimulationSeedInterface->SetMax( 0x7FFFFFFF );
+    mSimulationSeedInterface->SetInteger( ( int )mSimulationSeed );
+
+    mSimulationFaultsInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mSimulationFaultsInterface->SetTitleAndTooltip( "Simulated faults", "Errors injected into simulated data" );
+    mSimulationFaultsInterface->AddNumber( kFaultsNone, "None", "" );
+    mSimulationFaultsInterface->AddNumber( kFaultsRare, "Rare", "Each chosen kind of fault about once every 100000 characters" );
+    mSimulationFaultsInterface->AddNumber( kFaultsFrequent, "Frequent", "Each chosen kind of fault about once every 1000 characters" );
+    mSimulationFaultsInterface->SetNumber( mSimulationFaults );
+
+    mSimulationFaultKindInterface.reset( new AnalyzerSettingInterfaceNumberList() );
+    mSimulationFaultKindInterface->SetTitleAndTooltip( "Simulated fault kind", "Kind of error injected into simulated data" );
+    mSimulationFaultKindInterface->AddNumber( SimulationTrafficStruct::kFaultCount, "All kinds", "Every kind of fault at the same rate" );
+    mSimulationFaultKindInterface->AddNumber( SimulationTrafficStruct::kFaultParity, "Parity errors", "" );
+    mSimulationFaultKindInterface->AddNumber( SimulationTrafficStruct::kFaultCoincidentEdges, "Coincident edges",
+                                              "Data and strobe toggling on the same sample" );
+    mSimulationFaultKindInterface->AddNumber( SimulationTrafficStruct::kFaultTruncatedCharacter, "Truncated characters",
+                                              "A data character cut short by the link dropping" );
+    mSimulationFaultKindInterface->AddNumber( SimulationTrafficStruct::kFaultEscape, "Escape errors", "ESC followed by EOP" );
+    mSimulationFaultKindInterface->AddNumber( SimulationTrafficStruct::kFaultErrorPacket, "Error packets", "A packet ended early by EEP" );
+    mSimulationFaultKindInterface->AddNumber( SimulationTrafficStruct::kFaultTimecodeSkip, "Time-code skips",
+                                              "A time-code value left out" );
+    mSimulationFaultKindInterface->AddNumber( SimulationTrafficStruct::kFaultRateChange, "Rate changes",
+                                              "A switch to a random rate between the start-up and link rates" );
+    mSimulationFaultKindInterface->SetNumber( mSimulationFaultKind );
+
+    mSimulationFaultSeedInterface.reset( new AnalyzerSettingInterfaceInteger() );
+    mSimulationFaultSeedInterface->SetTitleAndTooltip(
+        "Simulated fault seed", "Seed of the fault injection, kept apart from the simulation seed so faults don't change the packets" );
+    mSimulationFaultSeedInterface->SetMin( 1 );
+    mSimulationFaultSeedInterface->SetMax( 0x7FFFFFFF );
+    mSimulationFaultSeedInterface->SetInteger( ( int )mSimulationFaultSeed );
+
     AddInterface( mDataChannelInterface.get() );
     AddInterface( mStrobeChannelInterface.get() );
+    AddInterface( mReverseDataChannelInterface.get() );
+    AddInterface( mReverseStrobeChannelInterface.get() );
     AddInterface( mCombineCharsInterface.get() );
     AddInterface( mShowNullsInterface.get() );
     AddInterface( mShowFctsInterface.get() );
+    AddInterface( mCollapseRunsInterface.get() );
     AddInterface( mShowTimecodesInterface.get() );
     AddInterface( mShowRegularPacketsInterface.get() );
     AddInterface( mShowErrorPacketsInterface.get() );
     AddInterface( mShowErrorsInterface.get() );
     AddInterface( mShowLinkSpeedChangesInterface.get() );
+    AddInterface( mShowTimecodeJitterInterface.get() );
+    AddInterface( mDecodeRmapInterface.get() );
     AddInterface( mDesyncAfterErrorInterface.get() );
+    AddInterface( mLinkRateInterface.get() );
+    AddInterface( mBitRecoveryInterface.get() );
+    AddInterface( mDecodeModeInterface.get() );
+    AddInterface( mPayloadModeInterface.get() );
+    AddInterface( mKeepCharactersInterface.get() );
+    AddInterface( mSimulationRateInterface.get() );
+    AddInterface( mSimulationPacketsInterface.get() );
+    AddInterface( mSimulationNullsInterface.get() );
+    AddInterface( mSimulationTimecodeInterface.get() );
+    AddInterface( mSimulationSeedInterface.get() );
+    AddInterface( mSimulationFaultsInterface.get() );
+    AddInterface( mSimulationFaultKindInterface.get() );
+    AddInterface( mSimulationFaultSeedInterface.get() );
 
-    AddExportOption( 0, "Export as text/csv file" );
-    AddExportExtension( 0, "text", "txt" );
-    AddExportExtension( 0, "csv", "csv" );
+    AddExportOption( kExportCsv, "Export as text/csv file" );
+    AddExportExtension( kExportCsv, "text", "txt" );
+    AddExportExtension( kExportCsv, "csv", "csv" );
+    AddExportOption( kExportPcapng, "Export packets as pcapng file" );
+    AddExportExtension( kExportPcapng, "pcapng", "pcapng" );
+    AddExportOption( kExportStatistics, "Export link statistics" );
+    AddExportExtension( kExportStatistics, "csv", "csv" );
+    AddExportOption( kExportTimecodes, "Export time-code analysis" );
+    AddExportExtension( kExportTimecodes, "csv", "csv" );
 
     ClearChannels();
     AddChannel( mDataChannel, "Data", false );
     AddChannel( mStrobeChannel, "Strobe", false );
+    AddChannel( mReverseDataChannel, "Reverse Data", false );
+    AddChannel( mReverseStrobeChannel, "Reverse Strobe", false );
 }
 
 SpaceWireAnalyzerSettings::~SpaceWireAnalyzerSettings()
@@ -95,21 +275,50 @@ SpaceWireAnalyzerSettings::~SpaceWireAnalyzerSettings()
 
 bool SpaceWireAnalyzerSettings::SetSettingsFromInterfaces()
 {
+    Channel reverseData = mReverseDataChannelInterface->GetChannel();
+    Channel reverseStrobe = mReverseStrobeChannelInterface->GetChannel();
+    if( ( reverseData == UNDEFINED_CHANNEL ) != ( reverseStrobe == UNDEFINED_CHANNEL ) )
+    {
+        SetErrorText( "Set both reverse channels, or neither" );
+        return false;
+    }
+
     mDataChannel = mDataChannelInterface->GetChannel();
     mStrobeChannel = mStrobeChannelInterface->GetChannel();
+    mReverseDataChannel = reverseData;
+    mReverseStrobeChannel = reverseStrobe;
     mCombineChars = mCombineCharsInterface->GetValue();
     mShowNulls = mShowNullsInterface->GetValue();
     mShowFcts = mShowFctsInterface->GetValue();
+    mCollapseRuns = mCollapseRunsInterface->GetValue();
     mShowTimecodes = mShowTimecodesInterface->GetValue();
     mShowRegularPackets = mShowRegularPacketsInterface->GetValue();
     mShowErrorPackets = mShowErrorPacketsInterface->GetValue();
     mShowErrors = mShowErrorsInterface->GetValue();
     mShowLinkSpeedChanges = mShowLinkSpeedChangesInterface->GetValue();
+    mShowTimecodeJitter = mShowTimecodeJitterInterface->GetValue();
+    mDecodeRmap = mDecodeRmapInterface->GetValue();
     mDesyncAfterError = mDesyncAfterErrorInterface->GetValue();
+    mLinkRateMbps = ( U32 )mLinkRateInterface->GetNumber();
+    mBitRecovery = ( U32 )mBitRecoveryInterface->GetNumber();
+    mDecodeMode = ( U32 )mDecodeModeInterface->GetNumber();
+    mPayloadMode = ( U32 )mPayloadModeInterface->GetNumber();
+    mKeepCharacters = mKeepCharactersInterface->GetValue();
+    mSimulationRateMbps = ( U32 )mSimulationRateInterface->GetNumber();
+    mSimulationPackets = ( U32 )mSimulationPacketsInterface->GetNumber();
+    mSimulationNulls = ( U32 )mSimulationNullsInterface->GetNumber();
+    mSimulationTimecodePeriodUs = ( U32 )mSimulationTimecodeInterface->GetNumber();
+    mSimulationSeed = ( U32 )mSimulationSeedInterface->GetInteger();
+    mSimulationFaults = ( U32 )mSimulationFaultsInterface->GetNumber();
+    mSimulationFaultKind = ( U32 )mSimulationFaultKindInterface->GetNumber();
+    mSimulationFaultSeed = ( U32 )mSimulationFaultSeedInterface->GetInteger();
+    ++mEditCount;
 
     ClearChannels();
     AddChannel( mDataChannel, "Data", true );
     AddChannel( mStrobeChannel, "Strobe", true );
+    AddChannel( mReverseDataChannel, "Reverse Data", HasReverseChannels() );
+    AddChannel( mReverseStrobeChannel, "Reverse Strobe", HasReverseChannels() );
 
     return true;
 }
@@ -118,15 +327,33 @@ void SpaceWireAnalyzerSettings::UpdateInterfacesFromSettings()
 {
     mDataChannelInterface->SetChannel( mDataChannel );
     mStrobeChannelInterface->SetChannel( mStrobeChannel );
+    mReverseDataChannelInterface->SetChannel( mReverseDataChannel );
+    mReverseStrobeChannelInterface->SetChannel( mReverseStrobeChannel );
     mCombineCharsInterface->SetValue( mCombineChars );
     mShowNullsInterface->SetValue( mShowNulls );
     mShowFctsInterface->SetValue( mShowFcts );
+    mCollapseRunsInterface->SetValue( mCollapseRuns );
     mShowTimecodesInterface->SetValue( mShowTimecodes );
     mShowRegularPacketsInterface->SetValue( mShowRegularPackets );
     mShowErrorPacketsInterface->SetValue( mShowErrorPackets );
     mShowErrorsInterface->SetValue( mShowErrors );
     mShowLinkSpeedChangesInterface->SetValue( mShowLinkSpeedChanges );
+    mShowTimecodeJitterInterface->SetValue( mShowTimecodeJitter );
+    mDecodeRmapInterface->SetValue( mDecodeRmap );
     mDesyncAfterErrorInterface->SetValue( mDesyncAfterError );
+    mLinkRateInterface->SetNumber( mLinkRateMbps );
+    mBitRecoveryInterface->SetNumber( mBitRecovery );
+    mDecodeModeInterface->SetNumber( mDecodeMode );
+    mPayloadModeInterface->SetNumber( mPayloadMode );
+    mKeepCharactersInterface->SetValue( mKeepCharacters );
+    mSimulationRateInterface->SetNumber( mSimulationRateMbps );
+    mSimulationPacketsInterface->SetNumber( mSimulationPackets );
+    mSimulationNullsInterface->SetNumber( mSimulationNulls );
+    mSimulationTimecodeInterface->SetNumber( mSimulationTimecodePeriodUs );
+    mSimulationSeedInterface->SetInteger( ( int )mSimulationSeed );
+    mSimulationFaultsInterface->SetNumber( mSimulationFaults );
+    mSimulationFaultKindInterface->SetNumber( mSimulationFaultKind );
+    mSimulationFaultSeedInterface->SetInteger( ( int )mSimulationFaultSeed );
 }
 
 void SpaceWireAnalyzerSettings::LoadSettings( const char* settings )
@@ -145,10 +372,30 @@ void SpaceWireAnalyzerSettings::LoadSettings( const char* settings )
     text_archive >> mShowErrors;
     text_archive >> mShowLinkSpeedChanges;
     text_archive >> mDesyncAfterError;
+    text_archive >> mDecodeMode;
+    text_archive >> mReverseDataChannel;
+    text_archive >> mReverseStrobeChannel;
+    text_archive >> mShowTimecodeJitter;
+    text_archive >> mDecodeRmap;
+    text_archive >> mPayloadMode;
+    text_archive >> mSimulationRateMbps;
+    text_archive >> mSimulationFaults;
+    text_archive >> mCollapseRuns;
+    text_archive >> mLinkRateMbps;
+    text_archive >> mBitRecovery;
+    text_archive >> mKeepCharacters;
+    text_archive >> mSimulationPackets;
+    text_archive >> mSimulationNulls;
+    text_archive >> mSimulationTimecodePeriodUs;
+    text_archive >> mSimulationSeed;
+    text_archive >> mSimulationFaultKind;
+    text_archive >> mSimulationFaultSeed;
 
     ClearChannels();
     AddChannel( mDataChannel, "Data", true );
     AddChannel( mStrobeChannel, "Strobe", true );
+    AddChannel( mReverseDataChannel, "Reverse Data", HasReverseChannels() );
+    AddChannel( mReverseStrobeChannel, "Reverse Strobe", HasReverseChannels() );
 
     UpdateInterfacesFromSettings();
 }
@@ -168,6 +415,40 @@ const char* SpaceWireAnalyzerSettings::SaveSettings()
     text_archive << mShowErrors;
     text_archive << mShowLinkSpeedChanges;
     text_archive << mDesyncAfterError;
+    text_archive << mDecodeMode;
+    text_archive << mReverseDataChannel;
+    text_archive << mReverseStrobeChannel;
+    text_archive << mShowTimecodeJitter;
+    text_archive << mDecodeRmap;
+    text_archive << mPayloadMode;
+    text_archive << mSimulationRateMbps;
+    text_archive << mSimulationFaults;
+    text_archive << mCollapseRuns;
+    text_archive << mLinkRateMbps;
+    text_archive << mBitRecovery;
+    text_archive << mKeepCharacters;
+    text_archive << mSimulationPackets;
+    text_archive << mSimulationNulls;
+    text_archive << mSimulationTimecodePeriodUs;
+    text_archive << mSimulationSeed;
+    text_archive << mSimulationFaultKind;
+    text_archive << mSimulationFaultSeed;
 
     return SetReturnString( text_archive.GetString() );
 }
+
+bool SpaceWireAnalyzerSettings::HasReverseChannels() const
+{
+    return mReverseDataChannel != UNDEFINED_CHANNEL && mReverseStrobeChannel != UNDEFINED_CHANNEL;
+}
+
+U64 SpaceWireAnalyzerSettings::GetPairedEdgeSamples( U32 sampleRateHz ) const
+{
+    if( mBitRecovery != kRecoveryTolerant )
+    {
+        return 0;
+    }
+    // two bit periods at the link rate rounded up, and a sample more as the edges are quantized
+    U64 linkRateBps = ( U64 )mLinkRateMbps * 1000000;
+    return ( 2 * ( U64 )sampleRateHz + linkRateBps - 1 ) / linkRateBps + 1;
+}
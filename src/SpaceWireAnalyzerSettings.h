@@ -14,29 +14,134 @@ class SpaceWireAnalyzerSettings : public AnalyzerSettings
     virtual void LoadSettings( const char* settings );
     virtual const char* SaveSettings();
 
+    // return true if the reverse direction channels are set
+    bool HasReverseChannels() const;
+    // return the paired edge window of the bit streams for the bit recovery setting
+    U64 GetPairedEdgeSamples( U32 sampleRateHz ) const;
+
+    // export file types (export_type_user_id)
+    enum ExportTypeEnum : U32
+    {
+        kExportCsv,
+        kExportPcapng,
+        kExportStatistics,
+        kExportTimecodes,
+    };
+
+    // how decoding is spread across threads
+    enum DecodeModeEnum : U32
+    {
+        kDecodeSingleThread,
+        kDecodePipelined,
+        kDecodeSegmented,
+    };
+
+    // how much of each packet is kept
+    enum PayloadModeEnum : U32
+    {
+        kPayloadFull,
+        // the first and last bytes and a digest of the rest
+        kPayloadDigest,
+    };
+
+    // how bits are recovered when data and strobe change on the same sample
+    enum BitRecoveryEnum : U32
+    {
+        // as a loss of sync
+        kRecoveryStrict,
+        // as two bits, if they come within two bit periods at the link rate
+        kRecoveryTolerant,
+    };
+
+    // lengths of simulated packets
+    enum SimulationPacketsEnum : U32
+    {
+        // 4 to 64 bytes
+        kPacketsSmall,
+        // 4 to 1024 bytes
+        kPacketsMixed,
+        // 1 KiB to 64 KiB
+        kPacketsLarge,
+    };
+
+    // faults injected into simulated data
+    enum SimulationFaultsEnum : U32
+    {
+        kFaultsNone,
+        kFaultsRare,
+        kFaultsFrequent,
+    };
+
     Channel mDataChannel;
     Channel mStrobeChannel;
+    // data and strobe of the opposite direction of the link (optional, for credit tracking)
+    Channel mReverseDataChannel;
+    Channel mReverseStrobeChannel;
 
     bool mCombineChars;
     bool mShowNulls;
     bool mShowFcts;
+    // show back-to-back NULLs or FCTs as one frame
+    bool mCollapseRuns;
     bool mShowTimecodes;
     bool mShowRegularPackets;
     bool mShowErrorPackets;
     bool mShowErrors;
     bool mShowLinkSpeedChanges;
+    bool mShowTimecodeJitter;
+    bool mDecodeRmap;
     bool mDesyncAfterError;
+    // highest bit rate expected on the link
+    U32 mLinkRateMbps;
+    U32 mBitRecovery;
+    U32 mDecodeMode;
+    U32 mPayloadMode;
+    // keep the decoded characters so a change of display settings only rebuilds the frames
+    bool mKeepCharacters;
+    // bit rate of the simulated link after start-up
+    U32 mSimulationRateMbps;
+    // traffic of the simulated link: packet lengths, NULLs between packets, time-code period
+    // (0 for none) and the seed of the random packet lengths
+    U32 mSimulationPackets;
+    U32 mSimulationNulls;
+    U32 mSimulationTimecodePeriodUs;
+    U32 mSimulationSeed;
+    U32 mSimulationFaults;
+    // the kind of fault injected (a SimulationTrafficStruct::FaultEnum, kFaultCount for every
+    // kind) and the seed of the fault injection
+    U32 mSimulationFaultKind;
+    U32 mSimulationFaultSeed;
+    // number of times the settings were applied from the interfaces (not saved)
+    U32 mEditCount;
 
   protected:
     std::auto_ptr<AnalyzerSettingInterfaceChannel> mDataChannelInterface;
     std::auto_ptr<AnalyzerSettingInterfaceChannel> mStrobeChannelInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceChannel> mReverseDataChannelInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceChannel> mReverseStrobeChannelInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mCombineCharsInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mShowNullsInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mShowFctsInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceBool> mCollapseRunsInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mShowTimecodesInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mShowRegularPacketsInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mShowErrorPacketsInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mShowErrorsInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mShowLinkSpeedChangesInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceBool> mShowTimecodeJitterInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceBool> mDecodeRmapInterface;
     std::auto_ptr<AnalyzerSettingInterfaceBool> mDesyncAfterErrorInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mLinkRateInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mBitRecoveryInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mDecodeModeInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mPayloadModeInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceBool> mKeepCharactersInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mSimulationRateInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mSimulationPacketsInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mSimulationNullsInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mSimulationTimecodeInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mSimulationSeedInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mSimulationFaultsInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mSimulationFaultKindInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mSimulationFaultSeedInterface;
 };
@@ -0,0 +1,218 @@
+#include "SpaceWireBitStream.h"
+
+#include <AnalyzerChannelData.h>
+
+SpaceWireEdgeSource::~SpaceWireEdgeSource()
+{
+}
+
+SpaceWireChannelEdgeSource::SpaceWireChannelEdgeSource() : mChannel( NULL )
+{
+}
+
+void SpaceWireChannelEdgeSource::SetChannel( AnalyzerChannelData* channel )
+{
+    mChannel = channel;
+    mEdges.Reset();
+    mSdkCalls.Reset();
+}
+
+U64 SpaceWireChannelEdgeSource::GetSampleNumber()
+{
+    mSdkCalls.Add( 1 );
+    return mChannel->GetSampleNumber();
+}
+
+BitState SpaceWireChannelEdgeSource::GetBitState()
+{
+    mSdkCalls.Add( 1 );
+    return mChannel->GetBitState();
+}
+
+U32 SpaceWireChannelEdgeSource::FetchEdges( U64* edges, U32 maxCount )
+{
+    U32 count = 0;
+    while( count < maxCount && mChannel->DoMoreTransitionsExistInCurrentData() )
+    {
+        mChannel->AdvanceToNextEdge();
+        edges[ count++ ] = mChannel->GetSampleNumber();
+    }
+    // three calls per edge, and one more to find there are no more
+    mEdges.Add( count );
+    mSdkCalls.Add( 3 * count + ( ( count < maxCount ) ? 1 : 0 ) );
+    return count;
+}
+
+SpaceWireBitStream::SpaceWireBitStream() : mDataSource( NULL ), mStrobeSource( NULL ), mDisconnectSamples( 0 ), mPairedEdgeSamples( 0 )
+{
+    ResetSkew();
+}
+
+void SpaceWireBitStream::SetSampleRate( U32 sampleRateHz )
+{
+    mDisconnectSamples = ( U64 )sampleRateHz * kDisconnectTimeoutNs / 1000000000;
+}
+
+void SpaceWireBitStream::SetPairedEdgeSamples( U64 pairSamples )
+{
+    mPairedEdgeSamples = pairSamples;
+}
+
+void SpaceWireBitStream::Reset( SpaceWireEdgeSource* data, SpaceWireEdgeSource* strobe )
+{
+    mDataSource = data;
+    mStrobeSource = strobe;
+    mDataEdges.count = 0;
+    mDataEdges.index = 0;
+    mDataEdges.exhausted = false;
+    mStrobeEdges.count = 0;
+    mStrobeEdges.index = 0;
+    mStrobeEdges.exhausted = false;
+    ResetSkew();
+
+    // the first bit starts wherever the channels currently are
+    mPendingBit.firstSample = mDataSource->GetSampleNumber();
+    mPendingBit.flags = 0;
+    if( mDataSource->GetBitState() == BIT_HIGH )
+    {
+        mPendingBit.flags |= RecoveredBitStruct::kData;
+    }
+    if( mStrobeSource->GetBitState() == BIT_HIGH )
+    {
+        mPendingBit.flags |= RecoveredBitStruct::kStrobe;
+    }
+}
+
+void SpaceWireBitStream::ResetSkew()
+{
+    mPendingToggle = 0;
+    mDataStartedSamples = 0;
+    mDataStartedCount = 0;
+    mStrobeStartedSamples = 0;
+    mStrobeStartedCount = 0;
+}
+
+void SpaceWireBitStream::AddBitLength( U8 startToggle, U8 endToggle, U64 length )
+{
+    // only bits between lone edges on different lines, and not across a gap in the traffic
+    if( length > mPairedEdgeSamples || startToggle == endToggle )
+    {
+        return;
+    }
+    if( startToggle == RecoveredBitStruct::kData && endToggle == RecoveredBitStruct::kStrobe )
+    {
+        mDataStartedSamples += length;
+        ++mDataStartedCount;
+    }
+    else if( startToggle == RecoveredBitStruct::kStrobe && endToggle == RecoveredBitStruct::kData )
+    {
+        mStrobeStartedSamples += length;
+        ++mStrobeStartedCount;
+    }
+
+    // follow changes in the skew, and keep the products in IsDataLagging() small
+    if( mDataStartedCount + mStrobeStartedCount > kSkewBitCount )
+    {
+        mDataStartedSamples /= 2;
+        mDataStartedCount /= 2;
+        mStrobeStartedSamples /= 2;
+        mStrobeStartedCount /= 2;
+    }
+}
+
+bool SpaceWireBitStream::Refill( SpaceWireEdgeSource* source, EdgeBufferStruct& buffer )
+{
+    if( buffer.index < buffer.count )
+    {
+        return true;
+    }
+    if( buffer.exhausted )
+    {
+        return false;
+    }
+    buffer.index = 0;
+    buffer.count = source->FetchEdges( buffer.edge, kEdgeBlockSize );
+    if( buffer.count == 0 )
+    {
+        buffer.exhausted = true;
+        return false;
+    }
+    return true;
+}
+
+U32 SpaceWireBitStream::ReadBits( RecoveredBitStruct* bits, U32 maxCount )
+{
+    U32 count = 0;
+    // the next edge on both lines must be known to tell which one comes first
+    while( count < maxCount && Refill( mDataSource, mDataEdges ) && Refill( mStrobeSource, mStrobeEdges ) )
+    {
+        U32 dataEnd = mDataEdges.count - mDataEdges.index;
+        U32 strobeEnd = mStrobeEdges.count - mStrobeEdges.index;
+        const U64* dataEdge = &mDataEdges.edge[ mDataEdges.index ];
+        const U64* strobeEdge = &mStrobeEdges.edge[ mStrobeEdges.index ];
+        U32 d = 0;
+        U32 s = 0;
+
+        // merge until either buffer runs out
+        RecoveredBitStruct bit = mPendingBit;
+        U8 startToggle = mPendingToggle;
+        while( count < maxCount && d < dataEnd && s < strobeEnd )
+        {
+            U64 nextSample;
+            U8 toggle;
+            if( dataEdge[ d ] < strobeEdge[ s ] )
+            {
+                nextSample = dataEdge[ d++ ];
+                toggle = RecoveredBitStruct::kData;
+            }
+            else if( strobeEdge[ s ] < dataEdge[ d ] )
+            {
+                nextSample = strobeEdge[ s++ ];
+                toggle = RecoveredBitStruct::kStrobe;
+            }
+            else if( mPairedEdgeSamples != 0 && strobeEdge[ s ] - bit.firstSample <= mPairedEdgeSamples )
+            {
+                // at a low sample rate two bits in a row can start on the same sample.  take the
+                // edge of the lagging line as the first, leaving a bit with a guessed value
+                if( IsDataLagging() )
+                {
+                    nextSample = dataEdge[ d++ ];
+                    toggle = RecoveredBitStruct::kData | RecoveredBitStruct::kAmbiguous;
+                }
+                else
+                {
+                    nextSample = strobeEdge[ s++ ];
+                    toggle = RecoveredBitStruct::kStrobe | RecoveredBitStruct::kAmbiguous;
+                }
+            }
+            else
+            {
+                nextSample = dataEdge[ d++ ];
+                ++s;
+                toggle = RecoveredBitStruct::kData | RecoveredBitStruct::kStrobe;
+                bit.flags |= RecoveredBitStruct::kCoincidentEnd;
+            }
+
+            // a receiver which sees no edge for this long resets and starts over
+            if( mDisconnectSamples != 0 && nextSample - bit.firstSample > mDisconnectSamples )
+            {
+                bit.flags |= RecoveredBitStruct::kDisconnectEnd;
+            }
+
+            if( mPairedEdgeSamples != 0 )
+            {
+                AddBitLength( startToggle, toggle, nextSample - bit.firstSample );
+                startToggle = toggle;
+            }
+
+            bits[ count++ ] = bit;
+            bit.firstSample = nextSample;
+            bit.flags = ( ( bit.flags & ( RecoveredBitStruct::kData | RecoveredBitStruct::kStrobe ) ) ^ toggle );
+        }
+        mPendingBit = bit;
+        mPendingToggle = startToggle;
+        mDataEdges.index += d;
+        mStrobeEdges.index += s;
+    }
+    return count;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <LogicPublicTypes.h>
+
+#include "SpaceWireInstrumentation.h"
+
+class AnalyzerChannelData;
+
+// a source of transitions on a single channel
+class SpaceWireEdgeSource
+{
+  public:
+    virtual ~SpaceWireEdgeSource();
+
+    // return the sample number the source is currently positioned at
+    virtual U64 GetSampleNumber() = 0;
+    // return the state of the channel at the current position
+    virtual BitState GetBitState() = 0;
+    // copy the samples of up to maxCount following edges into edges and advance past them
+    // returns the number of edges copied, or 0 if there are no more edges in the current data
+    virtual U32 FetchEdges( U64* edges, U32 maxCount ) = 0;
+};
+
+// edge source reading from the analyzer channel data of the SDK
+class SpaceWireChannelEdgeSource : public SpaceWireEdgeSource
+{
+  public:
+    SpaceWireChannelEdgeSource();
+
+    // set the channel to read from
+    void SetChannel( AnalyzerChannelData* channel );
+
+    virtual U64 GetSampleNumber();
+    virtual BitState GetBitState();
+    virtual U32 FetchEdges( U64* edges, U32 maxCount );
+
+    // return the number of edges read and of channel calls made (instrumented builds only)
+    U64 GetEdgeCount() const
+    {
+        return mEdges.Get();
+    }
+    U64 GetSdkCallCount() const
+    {
+        return mSdkCalls.Get();
+    }
+
+  protected:
+    AnalyzerChannelData* mChannel;
+
+    SpaceWireCounter mEdges;
+    SpaceWireCounter mSdkCalls;
+};
+
+// a single bit recovered from the data and strobe lines
+struct RecoveredBitStruct
+{
+    // bit flags
+    enum FlagEnum : U8
+    {
+        // data line is high during this bit
+        kData = 1 << 0,
+        // strobe line is high during this bit
+        kStrobe = 1 << 1,
+        // data and strobe both transition at the end of this bit
+        kCoincidentEnd = 1 << 2,
+        // the lines are silent for longer than the disconnect timeout after this bit starts
+        kDisconnectEnd = 1 << 3,
+        // this bit and the next started on the same sample, and their order is a guess, so the
+        // data value of this bit may be the opposite
+        kAmbiguous = 1 << 4,
+    };
+
+    // first sample of the bit
+    U64 firstSample;
+    // combination of FlagEnum values
+    U8 flags;
+};
+
+// merges the edges of the data and strobe lines into a single time-ordered bit stream
+class SpaceWireBitStream
+{
+  public:
+    // number of edges fetched from each channel at a time
+    static const U32 kEdgeBlockSize = 4096;
+    // a receiver must detect a disconnect after 727 to 1000 ns of silence (850 ns nominal), so
+    // only silence longer than the whole range is taken as one
+    static const U32 kDisconnectTimeoutNs = 1000;
+
+    SpaceWireBitStream();
+
+    // start reading from the given data and strobe sources
+    void Reset( SpaceWireEdgeSource* data, SpaceWireEdgeSource* strobe );
+    // set the sample rate, which enables disconnect detection (0 disables it)
+    void SetSampleRate( U32 sampleRateHz );
+    // take data and strobe edges on the same sample as two bits if they come within pairSamples
+    // of the start of the current bit, rather than as a loss of sync (0 never does)
+    void SetPairedEdgeSamples( U64 pairSamples );
+
+    // copy up to maxCount recovered bits into bits
+    // returns the number of bits copied, or 0 if there are no more bits in the current data
+    U32 ReadBits( RecoveredBitStruct* bits, U32 maxCount );
+
+  protected:
+    // edges fetched from one channel but not yet merged
+    struct EdgeBufferStruct
+    {
+        U64 edge[ kEdgeBlockSize ];
+        // number of valid edges
+        U32 count;
+        // index of the next edge to merge
+        U32 index;
+        // true once the source has no more edges in the current data
+        bool exhausted;
+    };
+
+    // make sure the buffer holds at least one unmerged edge, returns false if it can't
+    static bool Refill( SpaceWireEdgeSource* source, EdgeBufferStruct& buffer );
+
+    // forget the measured skew between the lines
+    void ResetSkew();
+    // measure the skew from the length of a bit started by startToggle and ended by endToggle
+    void AddBitLength( U8 startToggle, U8 endToggle, U64 length );
+    // return true if data edges come later than strobe edges, which shortens bits started by a
+    // data edge and lengthens those started by a strobe edge
+    bool IsDataLagging() const
+    {
+        return mDataStartedSamples * mStrobeStartedCount < mStrobeStartedSamples * mDataStartedCount;
+    }
+
+    SpaceWireEdgeSource* mDataSource;
+    SpaceWireEdgeSource* mStrobeSource;
+
+    EdgeBufferStruct mDataEdges;
+    EdgeBufferStruct mStrobeEdges;
+
+    // the current bit, which is emitted once the edge ending it is known
+    RecoveredBitStruct mPendingBit;
+    // bits longer than this end in a disconnect (0 to never detect one)
+    U64 mDisconnectSamples;
+    // coincident edges this soon after the start of a bit are two bits (0 if they never are)
+    U64 mPairedEdgeSamples;
+
+    // number of bits the skew is measured over
+    static const U64 kSkewBitCount = 1 << 16;
+    // the edge which started the current bit (with kAmbiguous if it was half of a pair)
+    U8 mPendingToggle;
+    // total length and number of bits started by a data edge and ended by a strobe edge, and the
+    // other way round
+    U64 mDataStartedSamples;
+    U64 mDataStartedCount;
+    U64 mStrobeStartedSamples;
+    U64 mStrobeStartedCount;
+};
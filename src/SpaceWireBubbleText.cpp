@@ -0,0 +1,585 @@
+#include "SpaceWireBubbleText.h"
+#include "SpaceWireAnalyzer.h"
+
+namespace
+{
+    constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+    // appends text to a fixed buffer, truncating at its end
+    class TextBuilder
+    {
+      public:
+        explicit TextBuilder( char* text ) : mText( text ), mLength( 0 )
+        {
+            mText[ 0 ] = 0;
+        }
+
+        U32 GetLength() const
+        {
+            return mLength;
+        }
+
+        void Append( char c )
+        {
+            if( mLength + 1 < BubbleTextStruct::kMaxLength )
+            {
+                mText[ mLength++ ] = c;
+                mText[ mLength ] = 0;
+            }
+        }
+
+        void Append( const char* text )
+        {
+            while( *text )
+            {
+                Append( *text++ );
+            }
+        }
+
+        void AppendHex( U8 value )
+        {
+            Append( kHexDigits[ value >> 4 ] );
+            Append( kHexDigits[ value & 0x0F ] );
+        }
+
+        void AppendUnsigned( U64 value )
+        {
+            char digits[ 20 ];
+            U32 count = 0;
+            do
+            {
+                digits[ count++ ] = '0' + ( char )( value % 10 );
+                value /= 10;
+            } while( value != 0 );
+            while( count != 0 )
+            {
+                Append( digits[ --count ] );
+            }
+        }
+
+        // append thousandths as a decimal number without trailing zeros
+        void AppendMilli( U64 value )
+        {
+            AppendUnsigned( value / 1000 );
+            U32 fraction = ( U32 )( value % 1000 );
+            if( fraction != 0 )
+            {
+                Append( '.' );
+                for( U32 scale = 100; fraction != 0; scale /= 10 )
+                {
+                    Append( ( char )( '0' + fraction / scale ) );
+                    fraction %= scale;
+                }
+            }
+        }
+
+      protected:
+        char* mText;
+        U32 mLength;
+    };
+
+    // convert samples to ns, split so the multiplication cannot overflow
+    U64 SamplesToNs( U64 samples, U32 sampleRateHz )
+    {
+        return ( samples / sampleRateHz ) * 1000000000ULL + ( samples % sampleRateHz ) * 1000000000ULL / sampleRateHz;
+    }
+
+    // append the time since the last timecode, and its jitter if the frame has one
+    void AppendDelta( TextBuilder& builder, const Frame& frame, U32 sampleRateHz )
+    {
+        builder.Append( " (delta=" );
+        builder.AppendMilli( SamplesToNs( frame.mData2, sampleRateHz ) );
+        builder.Append( " us" );
+        if( frame.mFlags & SpaceWireAnalyzer::kFlagJitter )
+        {
+            S64 jitter = ( S64 )frame.mData1 >> 8;
+            builder.Append( ", jitter=" );
+            if( jitter != 0 )
+            {
+                builder.Append( ( jitter < 0 ) ? '-' : '+' );
+            }
+            builder.AppendMilli( SamplesToNs( ( jitter < 0 ) ? ( U64 )0 - ( U64 )jitter : ( U64 )jitter, sampleRateHz ) );
+            builder.Append( " us" );
+        }
+        builder.Append( ')' );
+    }
+
+    // append the kind of an RMAP packet, e.g. "RMAP read command"
+    void AppendRmapKind( TextBuilder& builder, const RmapPacketStruct& packet )
+    {
+        builder.Append( packet.IsReadModifyWrite() ? "RMAP read-modify-write" : packet.IsWrite() ? "RMAP write" : "RMAP read" );
+        builder.Append( packet.IsCommand() ? " command" : " reply" );
+    }
+
+    void AppendHex32( TextBuilder& builder, U32 value )
+    {
+        for( S32 shift = 24; shift >= 0; shift -= 8 )
+        {
+            builder.AppendHex( ( U8 )( value >> shift ) );
+        }
+    }
+
+    // text of each RmapPacketStruct::ErrorEnum
+    const char* kRmapErrors[] = { "", " (truncated)", " (header CRC error)", " (data length mismatch)", " (data CRC error)" };
+
+    // append the transaction id, address, length or status of an RMAP packet, and any error
+    void AppendRmapFields( TextBuilder& builder, const RmapPacketStruct& packet )
+    {
+        if( packet.error != RmapPacketStruct::kErrorTruncated )
+        {
+            builder.Append( " tid=" );
+            builder.AppendUnsigned( packet.transactionId );
+            if( packet.IsCommand() )
+            {
+                builder.Append( " addr=0x" );
+                builder.AppendHex( packet.extendedAddress );
+                builder.Append( ':' );
+                AppendHex32( builder, packet.address );
+            }
+            else
+            {
+                builder.Append( " status=" );
+                builder.AppendUnsigned( packet.keyOrStatus );
+            }
+            if( packet.IsCommand() || packet.HasData() )
+            {
+                builder.Append( " len=" );
+                builder.AppendUnsigned( packet.dataLength );
+            }
+        }
+        builder.Append( kRmapErrors[ packet.error ] );
+    }
+
+    // return how many payload bytes of a packet frame were kept
+    U64 StoredLength( const Frame& frame, const PacketDigestStruct* digest )
+    {
+        U64 kept = SpaceWirePacketArena::kHeadBytes + SpaceWirePacketArena::kTailBytes;
+        return ( digest != NULL && frame.mData2 > kept ) ? kept : frame.mData2;
+    }
+
+    // add a level and return a builder for it
+    TextBuilder AddLevel( BubbleTextStruct& bubble )
+    {
+        return TextBuilder( bubble.text[ bubble.count++ ] );
+    }
+
+    void AddLevel( BubbleTextStruct& bubble, const char* text )
+    {
+        AddLevel( bubble ).Append( text );
+    }
+
+    // append up to maxBytes of a packet as hex, followed by the total length if truncated
+    void AppendPacket( BubbleTextStruct& bubble, const U8* data, U64 length, U32 maxBytes )
+    {
+        TextBuilder builder = AddLevel( bubble );
+        for( U32 i = 0; i < length && i < maxBytes; ++i )
+        {
+            builder.AppendHex( data[ i ] );
+        }
+        if( length > maxBytes )
+        {
+            builder.Append( " (" );
+            builder.AppendUnsigned( length );
+            builder.Append( " bytes total)" );
+        }
+    }
+}
+
+void SpaceWireBubbleFormatter::Format( const Frame& frame, const U8* packetData, const PacketDigestStruct* digest, U32 sampleRateHz,
+                                       BubbleTextStruct& bubble )
+{
+    static const char* controlShort[ 4 ] = { "F", "E", "EE", "ES" };
+    static const char* controlType[ 4 ] = { "FCT", "EOP", "EEP", "ESC" };
+
+    bubble.count = 0;
+    switch( frame.mType )
+    {
+    case SpaceWireAnalyzer::kTypeControlCharacter:
+        AddLevel( bubble, controlShort[ frame.mData1 & 0b11 ] );
+        AddLevel( bubble, controlType[ frame.mData1 & 0b11 ] );
+        if( frame.mData2 != 0 )
+        {
+            // a collapsed run of FCTs
+            TextBuilder builder = AddLevel( bubble );
+            builder.AppendUnsigned( frame.mData2 );
+            builder.Append( " FCTs" );
+        }
+        break;
+    case SpaceWireAnalyzer::kTypeDataCharacter:
+    {
+        TextBuilder builder = AddLevel( bubble );
+        builder.AppendHex( ( U8 )frame.mData1 );
+        builder = AddLevel( bubble );
+        builder.Append( "0x" );
+        builder.AppendHex( ( U8 )frame.mData1 );
+        break;
+    }
+    case SpaceWireAnalyzer::kTypeNull:
+        AddLevel( bubble, "N" );
+        AddLevel( bubble, "null" );
+        if( frame.mData2 != 0 )
+        {
+            // a collapsed run of NULLs
+            TextBuilder builder = AddLevel( bubble );
+            builder.AppendUnsigned( frame.mData2 );
+            builder.Append( " NULLs" );
+        }
+        break;
+    case SpaceWireAnalyzer::kTypeTimecode:
+    {
+        const char* prefix = ( frame.mFlags & SpaceWireAnalyzer::kFlagWarning ) ? "unexpected " : "";
+        TextBuilder builder = AddLevel( bubble );
+        builder.AppendUnsigned( ( U8 )frame.mData1 );
+        builder = AddLevel( bubble );
+        builder.Append( "TC " );
+        builder.AppendUnsigned( ( U8 )frame.mData1 );
+        builder = AddLevel( bubble );
+        builder.Append( prefix );
+        builder.Append( "timecode " );
+        builder.AppendUnsigned( ( U8 )frame.mData1 );
+        if( frame.mData2 && sampleRateHz != 0 )
+        {
+            builder = AddLevel( bubble );
+            builder.Append( prefix );
+            builder.Append( "timecode " );
+            builder.AppendUnsigned( ( U8 )frame.mData1 );
+            AppendDelta( builder, frame, sampleRateHz );
+        }
+        break;
+    }
+    case SpaceWireAnalyzer::kTypePacket:
+    {
+        // longer levels show more of the payload, until all of it fits
+        static const U32 packetBytes[] = { 4, 8, 32 };
+        RmapPacketStruct rmap;
+        if( ( frame.mFlags & SpaceWireAnalyzer::kFlagRmap ) && SpaceWireRmap::Decode( packetData, StoredLength( frame, digest ), frame.mData2, rmap ) )
+        {
+            AddLevel( bubble, "P" );
+            AddLevel( bubble, "RMAP" );
+            TextBuilder builder = AddLevel( bubble );
+            AppendRmapKind( builder, rmap );
+            builder = AddLevel( bubble );
+            AppendRmapKind( builder, rmap );
+            AppendRmapFields( builder, rmap );
+            break;
+        }
+        AddLevel( bubble, "P" );
+        for( U32 i = 0; i < 3; ++i )
+        {
+            AppendPacket( bubble, packetData, frame.mData2, packetBytes[ i ] );
+            if( frame.mData2 <= packetBytes[ i ] )
+            {
+                break;
+            }
+        }
+        break;
+    }
+    case SpaceWireAnalyzer::kTypeEmptyPacket:
+        AddLevel( bubble, "E" );
+        AddLevel( bubble, "empty" );
+        AddLevel( bubble, "empty packet" );
+        break;
+    case SpaceWireAnalyzer::kTypeErrorPacket:
+    {
+        AddLevel( bubble, "EEP" );
+        AddLevel( bubble, "error packet" );
+        TextBuilder builder = AddLevel( bubble );
+        builder.Append( "error packet (" );
+        builder.AppendUnsigned( frame.mData2 );
+        builder.Append( " bytes)" );
+        break;
+    }
+    case SpaceWireAnalyzer::kTypeEscapeError:
+        AddLevel( bubble, "!" );
+        AddLevel( bubble, "esc error" );
+        AddLevel( bubble, "escape error" );
+        break;
+    case SpaceWireAnalyzer::kTypeParityError:
+        AddLevel( bubble, "!" );
+        AddLevel( bubble, "parity" );
+        AddLevel( bubble, "parity error" );
+        break;
+    case SpaceWireAnalyzer::kTypeLinkSpeedChange:
+    {
+        // rates are shown in Mbit/s
+        TextBuilder builder = AddLevel( bubble );
+        builder.AppendMilli( frame.mData1 / 1000 );
+        builder = AddLevel( bubble );
+        builder.AppendMilli( frame.mData1 / 1000 );
+        builder.Append( " Mbps" );
+        builder = AddLevel( bubble );
+        builder.Append( "link speed " );
+        builder.AppendMilli( frame.mData1 / 1000 );
+        builder.Append( " Mbps" );
+        builder = AddLevel( bubble );
+        builder.Append( "link speed " );
+        builder.AppendMilli( frame.mData2 / 1000 );
+        builder.Append( " -> " );
+        builder.AppendMilli( frame.mData1 / 1000 );
+        builder.Append( " Mbps" );
+        break;
+    }
+    case SpaceWireAnalyzer::kTypeCreditError:
+    {
+        bool overflow = frame.mData1 == SpaceWireCreditTracker::kEventOverflow;
+        AddLevel( bubble, "!" );
+        AddLevel( bubble, ( overflow ) ? "credit overflow" : "credit underflow" );
+        TextBuilder builder = AddLevel( bubble );
+        builder.Append( ( frame.mData2 == SpaceWireCreditTracker::kDirectionReverse ) ? "reverse " : "forward " );
+        builder.Append( ( overflow ) ? "credit overflow" : "credit underflow" );
+        break;
+    }
+    default:
+        AddLevel( bubble, "UNKNOWN" );
+        break;
+    }
+}
+
+void SpaceWireBubbleFormatter::FormatTabular( const Frame& frame, const U8* packetData, const PacketDigestStruct* digest, U32 sampleRateHz,
+                                              char* text )
+{
+    static const char* controlType[ 4 ] = { "FCT", "EOP", "EEP", "ESC" };
+
+    // the text is what the data table searches, so spell out the type and header fields
+    TextBuilder builder( text );
+    switch( frame.mType )
+    {
+    case SpaceWireAnalyzer::kTypeControlCharacter:
+        // a collapsed run is spelled out with its count
+        if( frame.mData2 != 0 )
+        {
+            builder.AppendUnsigned( frame.mData2 );
+            builder.Append( " " );
+        }
+        builder.Append( controlType[ frame.mData1 & 0b11 ] );
+        if( frame.mData2 != 0 )
+        {
+            builder.Append( "s" );
+        }
+        break;
+    case SpaceWireAnalyzer::kTypeDataCharacter:
+        builder.Append( "0x" );
+        builder.AppendHex( ( U8 )frame.mData1 );
+        break;
+    case SpaceWireAnalyzer::kTypeNull:
+        if( frame.mData2 != 0 )
+        {
+            builder.AppendUnsigned( frame.mData2 );
+            builder.Append( " " );
+        }
+        builder.Append( ( frame.mData2 != 0 ) ? "NULLs" : "NULL" );
+        break;
+    case SpaceWireAnalyzer::kTypeTimecode:
+        if( frame.mFlags & SpaceWireAnalyzer::kFlagWarning )
+        {
+            builder.Append( "unexpected " );
+        }
+        builder.Append( "timecode " );
+        builder.AppendUnsigned( ( U8 )frame.mData1 );
+        if( frame.mData2 && sampleRateHz != 0 )
+        {
+            AppendDelta( builder, frame, sampleRateHz );
+        }
+        break;
+    case SpaceWireAnalyzer::kTypePacket:
+    case SpaceWireAnalyzer::kTypeErrorPacket:
+    {
+        RmapPacketStruct rmap;
+        if( ( frame.mFlags & SpaceWireAnalyzer::kFlagRmap ) && SpaceWireRmap::Decode( packetData, StoredLength( frame, digest ), frame.mData2, rmap ) )
+        {
+            AppendRmapKind( builder, rmap );
+            AppendRmapFields( builder, rmap );
+            break;
+        }
+        builder.Append( ( frame.mType == SpaceWireAnalyzer::kTypePacket ) ? "packet" : "error packet" );
+        if( frame.mData2 != 0 )
+        {
+            builder.Append( " addr=0x" );
+            builder.AppendHex( packetData[ 0 ] );
+        }
+        builder.Append( " len=" );
+        builder.AppendUnsigned( frame.mData2 );
+        if( digest != NULL )
+        {
+            // the checksum stands in for the bytes which weren't kept
+            builder.Append( " crc32=0x" );
+            AppendHex32( builder, digest->crc );
+        }
+        builder.Append( ' ' );
+        // as much of the payload as fits
+        U64 maxCount = ( digest != NULL ) ? 24 : 32;
+        U64 count = frame.mData2;
+        if( count > maxCount )
+        {
+            count = maxCount;
+        }
+        for( U64 i = 0; i < count; ++i )
+        {
+            builder.AppendHex( packetData[ i ] );
+        }
+        if( count < frame.mData2 )
+        {
+            builder.Append( "..." );
+        }
+        break;
+    }
+    case SpaceWireAnalyzer::kTypeEmptyPacket:
+        builder.Append( "empty packet" );
+        break;
+    case SpaceWireAnalyzer::kTypeEscapeError:
+        builder.Append( "escape error" );
+        break;
+    case SpaceWireAnalyzer::kTypeParityError:
+        builder.Append( "parity error" );
+        break;
+    case SpaceWireAnalyzer::kTypeCreditError:
+        builder.Append( ( frame.mData2 == SpaceWireCreditTracker::kDirectionReverse ) ? "reverse " : "forward " );
+        builder.Append( ( frame.mData1 == SpaceWireCreditTracker::kEventOverflow ) ? "credit overflow" : "credit underflow" );
+        break;
+    case SpaceWireAnalyzer::kTypeLinkSpeedChange:
+        builder.Append( "link speed change " );
+        builder.AppendMilli( frame.mData2 / 1000 );
+        builder.Append( " -> " );
+        builder.AppendMilli( frame.mData1 / 1000 );
+        builder.Append( " Mbps" );
+        break;
+    default:
+        builder.Append( "UNKNOWN" );
+        break;
+    }
+}
+
+void SpaceWireBubbleFormatter::FormatTransaction( const RmapTransactionStruct& transaction, U32 sampleRateHz, char* text )
+{
+    const RmapPacketStruct& command = transaction.command;
+    TextBuilder builder( text );
+    builder.Append( command.IsReadModifyWrite() ? "RMAP read-modify-write 0x" : command.IsWrite() ? "RMAP write 0x" : "RMAP read 0x" );
+    builder.AppendHex( command.initiatorAddress );
+    builder.Append( "->0x" );
+    builder.AppendHex( command.targetAddress );
+    AppendRmapFields( builder, command );
+
+    if( transaction.replied )
+    {
+        // latency is from the end of the command to the start of the reply
+        U64 latency = ( transaction.replyStartingSample > transaction.commandEndingSample )
+                          ? transaction.replyStartingSample - transaction.commandEndingSample
+                          : 0;
+        builder.Append( ": status=" );
+        builder.AppendUnsigned( transaction.reply.keyOrStatus );
+        builder.Append( kRmapErrors[ transaction.reply.error ] );
+        if( sampleRateHz != 0 )
+        {
+            builder.Append( " latency=" );
+            builder.AppendMilli( SamplesToNs( latency, sampleRateHz ) );
+            builder.Append( " us" );
+        }
+    }
+    else
+    {
+        builder.Append( command.WantsReply() ? ": no reply" : ": no reply requested" );
+    }
+}
+
+SpaceWireBubbleCache::SpaceWireBubbleCache() : mEntries( kCapacity ), mBuckets( kBucketCount )
+{
+    Clear();
+}
+
+void SpaceWireBubbleCache::Clear()
+{
+    for( std::vector<U32>::iterator it = mBuckets.begin(); it != mBuckets.end(); ++it )
+    {
+        *it = kNone;
+    }
+    mUsed = 0;
+    mNewest = kNone;
+    mOldest = kNone;
+}
+
+const BubbleTextStruct* SpaceWireBubbleCache::Find( U64 frameIndex )
+{
+    for( U32 entry = mBuckets[ Bucket( frameIndex ) ]; entry != kNone; entry = mEntries[ entry ].bucketNext )
+    {
+        if( mEntries[ entry ].frameIndex == frameIndex )
+        {
+            if( entry != mNewest )
+            {
+                Unlink( entry );
+                LinkNewest( entry );
+            }
+            return &mEntries[ entry ].bubble;
+        }
+    }
+    return NULL;
+}
+
+BubbleTextStruct* SpaceWireBubbleCache::Insert( U64 frameIndex )
+{
+    U32 entry;
+    if( mUsed < kCapacity )
+    {
+        entry = mUsed++;
+    }
+    else
+    {
+        // reuse the least recently used entry
+        entry = mOldest;
+        Unlink( entry );
+        RemoveFromBucket( entry );
+    }
+
+    EntryStruct& e = mEntries[ entry ];
+    e.frameIndex = frameIndex;
+    e.bucketNext = mBuckets[ Bucket( frameIndex ) ];
+    mBuckets[ Bucket( frameIndex ) ] = entry;
+    LinkNewest( entry );
+    return &e.bubble;
+}
+
+void SpaceWireBubbleCache::Unlink( U32 entry )
+{
+    EntryStruct& e = mEntries[ entry ];
+    if( e.newer != kNone )
+    {
+        mEntries[ e.newer ].older = e.older;
+    }
+    else
+    {
+        mNewest = e.older;
+    }
+    if( e.older != kNone )
+    {
+        mEntries[ e.older ].newer = e.newer;
+    }
+    else
+    {
+        mOldest = e.newer;
+    }
+}
+
+void SpaceWireBubbleCache::LinkNewest( U32 entry )
+{
+    EntryStruct& e = mEntries[ entry ];
+    e.newer = kNone;
+    e.older = mNewest;
+    if( mNewest != kNone )
+    {
+        mEntries[ mNewest ].newer = entry;
+    }
+    mNewest = entry;
+    if( mOldest == kNone )
+    {
+        mOldest = entry;
+    }
+}
+
+void SpaceWireBubbleCache::RemoveFromBucket( U32 entry )
+{
+    U32* link = &mBuckets[ Bucket( mEntries[ entry ].frameIndex ) ];
+    while( *link != entry )
+    {
+        link = &mEntries[ *link ].bucketNext;
+    }
+    *link = mEntries[ entry ].bucketNext;
+}
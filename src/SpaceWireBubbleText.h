@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+
+#include <AnalyzerResults.h>
+
+#include "SpaceWirePacketArena.h"
+#include "SpaceWireRmap.h"
+
+// bubble text of one frame at every detail level
+struct BubbleTextStruct
+{
+    // maximum number of detail levels and characters per level (including the terminator)
+    static const U32 kMaxLevels = 4;
+    static const U32 kMaxLength = 112;
+
+    // number of levels, shortest first
+    U32 count;
+    char text[ kMaxLevels ][ kMaxLength ];
+};
+
+// formats bubble text into fixed buffers without allocating or calling printf
+class SpaceWireBubbleFormatter
+{
+  public:
+    // format a frame at every detail level
+    // packetData is the frame's payload for packet frames, and digest its digest if only the head
+    // and tail of the payload were kept (NULL otherwise).  sampleRateHz converts timecode deltas
+    static void Format( const Frame& frame, const U8* packetData, const PacketDigestStruct* digest, U32 sampleRateHz,
+                        BubbleTextStruct& bubble );
+    // format a frame as a single line of tabular text into text (BubbleTextStruct::kMaxLength long)
+    static void FormatTabular( const Frame& frame, const U8* packetData, const PacketDigestStruct* digest, U32 sampleRateHz,
+                               char* text );
+    // format an RMAP transaction as a single line of tabular text into text (BubbleTextStruct::kMaxLength long)
+    static void FormatTransaction( const RmapTransactionStruct& transaction, U32 sampleRateHz, char* text );
+};
+
+// least recently used cache of formatted bubble text keyed by frame index
+//
+// all entries are allocated up front, so lookups and insertions never allocate.
+class SpaceWireBubbleCache
+{
+  public:
+    // number of frames kept
+    static const U32 kCapacity = 2048;
+
+    SpaceWireBubbleCache();
+
+    // drop all entries
+    void Clear();
+    // return the cached text of a frame and mark it most recently used, or NULL if not cached
+    const BubbleTextStruct* Find( U64 frameIndex );
+    // return an entry for a frame to be formatted into, evicting the least recently used frame
+    BubbleTextStruct* Insert( U64 frameIndex );
+
+  protected:
+    static const U32 kNone = 0xFFFFFFFF;
+    static const U32 kBucketCount = 2 * kCapacity;
+
+    struct EntryStruct
+    {
+        U64 frameIndex;
+        // neighbours in recency order
+        U32 newer;
+        U32 older;
+        // next entry in the same hash bucket
+        U32 bucketNext;
+        BubbleTextStruct bubble;
+    };
+
+    static U32 Bucket( U64 frameIndex )
+    {
+        return ( U32 )( frameIndex & ( kBucketCount - 1 ) );
+    }
+    // unlink an entry from the recency list
+    void Unlink( U32 entry );
+    // link an entry as the most recently used
+    void LinkNewest( U32 entry );
+    // remove an entry from its hash bucket
+    void RemoveFromBucket( U32 entry );
+
+    std::vector<EntryStruct> mEntries;
+    std::vector<U32> mBuckets;
+    U32 mUsed;
+    U32 mNewest;
+    U32 mOldest;
+};
@@ -0,0 +1,325 @@
+#include "SpaceWireCharacterDecoder.h"
+
+namespace
+{
+    // lookup table of every character, indexed by the data-control flag, the character bits
+    // and the parity and data-control flag of the following character
+    struct CharacterTableStruct
+    {
+        CharacterDecodeStruct entry[ 1 << BitWindowStruct::kDecodeBits ];
+
+        CharacterTableStruct()
+        {
+            const U32 topBit = BitWindowStruct::kDecodeBits - 1;
+            for( U32 key = 0; key < ( 1u << BitWindowStruct::kDecodeBits ); ++key )
+            {
+                CharacterDecodeStruct& c = entry[ key ];
+                c.control = ( key >> topBit ) & 1;
+                // bits covered by the following parity bit (character bits + next P + next F)
+                U32 coveredBits = ( c.control ) ? 4 : 10;
+                U32 covered = ( key & ( ( 1u << topBit ) - 1 ) ) >> ( topBit - coveredBits );
+                U32 ones = 0;
+                for( U32 i = 0; i < coveredBits; ++i )
+                {
+                    ones += ( covered >> i ) & 1;
+                }
+                // parity is odd over the covered bits
+                c.parityMatch = ( ones % 2 ) == 1;
+                if( c.control )
+                {
+                    // control codes are sent MSB first
+                    c.length = 4;
+                    c.value = ( covered >> 2 ) & 0b11;
+                }
+                else
+                {
+                    // data is sent LSB first
+                    c.length = 10;
+                    c.value = 0;
+                    for( U32 i = 0; i < 8; ++i )
+                    {
+                        c.value |= ( ( covered >> ( 9 - i ) ) & 1 ) << i;
+                    }
+                }
+            }
+        }
+    };
+
+    const CharacterTableStruct gCharacterTable;
+}
+
+// constructor
+BitWindowStruct::BitWindowStruct() : count( 0 ), value( 0 ), ambiguous( 0 ), head( 0 )
+{
+}
+
+// remove all bits from the buffer
+void BitWindowStruct::Clear()
+{
+    count = 0;
+    value = 0;
+    ambiguous = 0;
+}
+
+// return true if no more bits can be pushed
+bool BitWindowStruct::Full() const
+{
+    return count >= kCapacity;
+}
+
+// push a new bit into the buffer
+// (can only be called when count < kCapacity)
+void BitWindowStruct::Push( BitState state, U64 firstSampleOfBit, bool guessed )
+{
+    value <<= 1;
+    if( state == BIT_HIGH )
+    {
+        value |= 1;
+    }
+    ambiguous <<= 1;
+    if( guessed )
+    {
+        ambiguous |= 1;
+    }
+    firstSample[ ( head + count ) % kCapacity ] = firstSampleOfBit;
+    count += 1;
+}
+
+// return the Xth bit in the buffer
+U8 BitWindowStruct::Get( U32 index ) const
+{
+    return ( value >> ( count - index - 1 ) ) & 1;
+}
+
+// return bits [index, index + length) of the buffer, oldest bit as MSB
+U32 BitWindowStruct::Peek( U32 index, U32 length ) const
+{
+    return ( U32 )( value >> ( count - index - length ) ) & ( ( 1u << length ) - 1 );
+}
+
+// return the first sample of the Xth bit in the buffer
+U64 BitWindowStruct::FirstSample( U32 index ) const
+{
+    return firstSample[ ( head + index ) % kCapacity ];
+}
+
+// return bits [index, index + length) of the buffer, zero-padding any missing bits
+U32 BitWindowStruct::PeekPadded( U32 index, U32 length ) const
+{
+    U32 available = count - index;
+    if( available >= length )
+    {
+        return Peek( index, length );
+    }
+    return Peek( index, available ) << ( length - available );
+}
+
+// decode the character at the start of the buffer
+// (can only be called when count >= 2, result is only valid when count >= length + 2)
+const CharacterDecodeStruct& BitWindowStruct::Decode() const
+{
+    return gCharacterTable.entry[ PeekPadded( 1, kDecodeBits ) ];
+}
+
+// drop the oldest X bits
+void BitWindowStruct::Pop( U32 skip )
+{
+    count -= skip;
+    head += skip;
+    ConfirmGuesses( 0 );
+}
+
+// return the index of the first guessed bit in [index, index + length) of the buffer, or
+// index + length if there is none
+U32 BitWindowStruct::FindGuessed( U32 index, U32 length ) const
+{
+    for( U32 i = index; i < index + length && i < count; ++i )
+    {
+        if( ( ambiguous >> ( count - i - 1 ) ) & 1 )
+        {
+            return i;
+        }
+    }
+    return index + length;
+}
+
+// invert the Xth bit in the buffer
+void BitWindowStruct::Flip( U32 index )
+{
+    value ^= ( U64 )1 << ( count - index - 1 );
+}
+
+// forget which of the oldest X bits were guessed (and of any bits already popped)
+void BitWindowStruct::ConfirmGuesses( U32 length )
+{
+    U32 kept = count - length;
+    if( kept < 64 )
+    {
+        ambiguous &= ( ( U64 )1 << kept ) - 1;
+    }
+}
+
+SpaceWireCharacterDecoder::SpaceWireCharacterDecoder() : mSynchronized( false ), mDesyncAfterError( true )
+{
+}
+
+void SpaceWireCharacterDecoder::Reset()
+{
+    mSynchronized = false;
+    mBits.Clear();
+}
+
+void SpaceWireCharacterDecoder::SetDesyncAfterError( bool desyncAfterError )
+{
+    mDesyncAfterError = desyncAfterError;
+}
+
+bool SpaceWireCharacterDecoder::IsSynchronized() const
+{
+    return mSynchronized;
+}
+
+void SpaceWireCharacterDecoder::Decode( const RecoveredBitStruct* bits, U32 count, std::vector<DecodedCharacterStruct>& characters )
+{
+    // if not synced:
+    // 1) if not synced and S = D, skip a bit and desync
+    // 2) wait for 2 bits to come in
+    // 2a) if two transitions ever happen at the exact same time, desync and goto 1
+    // 3) if second bit is 1, wait for 6 bits, else wait for 10 bits
+    // 4) if second bit is 1, check parity on 5th bit (2-4,6), else check parity on 9th bit (2-8, 10)
+    // 5) if parity matches, save frame and skip frame bits, else desync, skip 2 bits
+    // 6) in either case, goto 2
+
+    for( U32 i = 0; i < count; ++i )
+    {
+        const RecoveredBitStruct& bit = bits[ i ];
+
+        // if they transition on the same sample, or the link went silent, decode what we have and
+        // then de-sync (silence only matters if there was something to lose)
+        bool coincident = ( bit.flags & RecoveredBitStruct::kCoincidentEnd ) != 0;
+        bool disconnect = ( bit.flags & RecoveredBitStruct::kDisconnectEnd ) && ( mSynchronized || mBits.count != 0 );
+        if( coincident || disconnect )
+        {
+            if( !coincident )
+            {
+                // the last bit before silence is whole, only its end is late
+                if( mBits.Full() )
+                {
+                    DecodeBufferedCharacters( characters );
+                }
+                mBits.Push( ( bit.flags & RecoveredBitStruct::kData ) ? BIT_HIGH : BIT_LOW, bit.firstSample,
+                            ( bit.flags & RecoveredBitStruct::kAmbiguous ) != 0 );
+            }
+            DecodeBufferedCharacters( characters );
+            Reset();
+            DecodedCharacterStruct c;
+            c.startingSample = bit.firstSample;
+            c.endingSample = bit.firstSample;
+            c.type = DecodedCharacterStruct::kDesync;
+            c.value = ( coincident ) ? DecodedCharacterStruct::kDesyncCoincident : DecodedCharacterStruct::kDesyncDisconnect;
+            characters.push_back( c );
+            continue;
+        }
+
+        // if this is the first bit, skip it if D == S (since parity bit has D != S)
+        bool dataHigh = ( bit.flags & RecoveredBitStruct::kData ) != 0;
+        bool strobeHigh = ( bit.flags & RecoveredBitStruct::kStrobe ) != 0;
+        if( !mSynchronized && mBits.count == 0 && dataHigh == strobeHigh )
+        {
+            continue;
+        }
+
+        // add this bit, and pull every complete character out of the window once it fills up
+        mBits.Push( ( dataHigh ) ? BIT_HIGH : BIT_LOW, bit.firstSample, ( bit.flags & RecoveredBitStruct::kAmbiguous ) != 0 );
+        if( mBits.Full() )
+        {
+            DecodeBufferedCharacters( characters );
+        }
+    }
+
+    DecodeBufferedCharacters( characters );
+}
+
+void SpaceWireCharacterDecoder::DecodeBufferedCharacters( std::vector<DecodedCharacterStruct>& characters )
+{
+    // need at least 2 bits to interpret frame type
+    while( mBits.count >= 2 )
+    {
+        // look up character type, value and parity
+        const CharacterDecodeStruct* c = &mBits.Decode();
+        U32 charLength = c->length;
+        // wait for more bits
+        if( mBits.count < charLength + 2 )
+        {
+            break;
+        }
+        // a guessed bit may be the wrong way round (this can change the character)
+        if( !c->parityMatch && mBits.ambiguous != 0 && RepairGuessedBit() )
+        {
+            c = &mBits.Decode();
+            charLength = c->length;
+        }
+
+        DecodedCharacterStruct character;
+        // get start/end samples of character
+        character.startingSample = mBits.FirstSample( 0 );
+        character.endingSample = mBits.FirstSample( charLength ) - 1;
+
+        // if parity matches, save the character
+        if( c->parityMatch )
+        {
+            // the stream is in sync once a character passes its parity check, which also settles
+            // any guessed bits it covered
+            mSynchronized = true;
+            mBits.ConfirmGuesses( charLength + 2 );
+            // pop bits from buffer
+            mBits.Pop( charLength );
+
+            character.type = ( c->control ) ? DecodedCharacterStruct::kControl : DecodedCharacterStruct::kData;
+            character.value = c->value;
+            characters.push_back( character );
+        }
+        else
+        {
+            // report parity error
+            if( mSynchronized )
+            {
+                character.type = DecodedCharacterStruct::kParityError;
+                character.value = 0;
+                characters.push_back( character );
+            }
+            if( mDesyncAfterError )
+            {
+                mSynchronized = false;
+            }
+            if( mSynchronized )
+            {
+                mBits.Pop( charLength );
+            }
+            else
+            {
+                mBits.Pop( 2 );
+            }
+        }
+    }
+}
+
+bool SpaceWireCharacterDecoder::RepairGuessedBit()
+{
+    // the check covers the flag, the character bits and the parity and flag of the next one
+    // (BitWindowStruct::kDecodeBits at most), and only one guess is tried
+    U32 index = mBits.FindGuessed( 1, BitWindowStruct::kDecodeBits );
+    if( index == 1 + BitWindowStruct::kDecodeBits )
+    {
+        return false;
+    }
+    mBits.Flip( index );
+    const CharacterDecodeStruct& c = mBits.Decode();
+    U32 checked = c.length + 2;
+    if( index < checked && mBits.count >= checked && c.parityMatch )
+    {
+        return true;
+    }
+    mBits.Flip( index );
+    return false;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+#include "SpaceWireBitStream.h"
+
+// a character as decoded from the character table
+struct CharacterDecodeStruct
+{
+    // number of bits in the character (4 for control characters, 10 for data characters)
+    U8 length;
+    // true for a control character, false for a data character
+    bool control;
+    // control code, or data byte with the bit order corrected
+    U8 value;
+    // true if the parity bit of the following character matches
+    bool parityMatch;
+};
+
+// holds up to 64 buffered bits along with the first sample of each bit
+struct BitWindowStruct
+{
+    // maximum number of bits which can be buffered
+    static const U32 kCapacity = 64;
+    // number of bits used to index the character table (flag + 8 data bits + next parity and flag)
+    static const U32 kDecodeBits = 11;
+    // number of bits buffered
+    U32 count;
+    // value of those bits (oldest bit is the most significant)
+    U64 value;
+    // bits whose value is a guess, aligned with value (only the low count bits are used)
+    U64 ambiguous;
+    // absolute index of the oldest buffered bit
+    U64 head;
+    // first sample of each bit, indexed by absolute bit index modulo capacity
+    U64 firstSample[ kCapacity ];
+    // constructor
+    BitWindowStruct();
+    // remove all bits from the buffer
+    void Clear();
+    // return true if no more bits can be pushed
+    bool Full() const;
+    // push a new bit into the buffer, marking it if its value is a guess
+    // (can only be called when count < kCapacity)
+    void Push( BitState state, U64 firstSampleOfBit, bool guessed );
+    // return the Xth bit in the buffer
+    U8 Get( U32 index ) const;
+    // return bits [index, index + length) of the buffer, oldest bit as MSB
+    U32 Peek( U32 index, U32 length ) const;
+    // return the first sample of the Xth bit in the buffer
+    U64 FirstSample( U32 index ) const;
+    // return bits [index, index + length) of the buffer, zero-padding any missing bits
+    U32 PeekPadded( U32 index, U32 length ) const;
+    // decode the character at the start of the buffer
+    // (can only be called when count >= 2, result is only valid when count >= length + 2)
+    const CharacterDecodeStruct& Decode() const;
+    // drop the oldest X bits
+    void Pop( U32 skip );
+    // return the index of the first guessed bit in [index, index + length) of the buffer, or
+    // index + length if there is none
+    U32 FindGuessed( U32 index, U32 length ) const;
+    // invert the Xth bit in the buffer
+    void Flip( U32 index );
+    // forget which of the oldest X bits were guessed
+    void ConfirmGuesses( U32 length );
+};
+
+// a character, or a decoder event, produced by SpaceWireCharacterDecoder
+struct DecodedCharacterStruct
+{
+    // character types
+    enum TypeEnum : U8
+    {
+        // control character (value is the control code)
+        kControl,
+        // data character (value is the data byte)
+        kData,
+        // character failed its parity check while synchronized
+        kParityError,
+        // the stream is no longer synchronized (value is one of DesyncEnum)
+        kDesync,
+    };
+
+    // why a kDesync was decoded
+    enum DesyncEnum : U8
+    {
+        // data and strobe transitioned together
+        kDesyncCoincident,
+        // the lines were silent for longer than the disconnect timeout
+        kDesyncDisconnect,
+    };
+
+    // first sample of the character
+    U64 startingSample;
+    // last sample of the character
+    U64 endingSample;
+    // one of TypeEnum
+    U8 type;
+    // character value
+    U8 value;
+};
+
+// decodes recovered bits into characters
+class SpaceWireCharacterDecoder
+{
+  public:
+    SpaceWireCharacterDecoder();
+
+    // return to the unsynchronized state
+    void Reset();
+    // set whether a parity error loses synchronization
+    void SetDesyncAfterError( bool desyncAfterError );
+    // return true if the decoder is synchronized to character boundaries
+    bool IsSynchronized() const;
+
+    // decode the given bits, appending every completed character to characters
+    void Decode( const RecoveredBitStruct* bits, U32 count, std::vector<DecodedCharacterStruct>& characters );
+
+  protected:
+    // decode every complete character held in mBits
+    void DecodeBufferedCharacters( std::vector<DecodedCharacterStruct>& characters );
+    // try inverting a guessed bit covered by the parity check of the character at the start of
+    // mBits, returns true (keeping the inverted bit) if that makes the check pass
+    bool RepairGuessedBit();
+
+    // buffered bits
+    BitWindowStruct mBits;
+    // true if stream is synchronized
+    bool mSynchronized;
+    // true if a parity error loses synchronization
+    bool mDesyncAfterError;
+};
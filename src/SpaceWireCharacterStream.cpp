@@ -0,0 +1,37 @@
+#include "SpaceWireCharacterStream.h"
+
+SpaceWireCharacterStream::SpaceWireCharacterStream() : mNext( 0 )
+{
+}
+
+void SpaceWireCharacterStream::Reset( AnalyzerChannelData* data, AnalyzerChannelData* strobe, U32 sampleRateHz, U64 pairedEdgeSamples,
+                                      bool desyncAfterError )
+{
+    mDataEdges.SetChannel( data );
+    mStrobeEdges.SetChannel( strobe );
+    mBitStream.Reset( &mDataEdges, &mStrobeEdges );
+    mBitStream.SetSampleRate( sampleRateHz );
+    mBitStream.SetPairedEdgeSamples( pairedEdgeSamples );
+    mDecoder.Reset();
+    mDecoder.SetDesyncAfterError( desyncAfterError );
+    mCharacters.clear();
+    mNext = 0;
+}
+
+bool SpaceWireCharacterStream::Fill()
+{
+    mCharacters.clear();
+    mNext = 0;
+
+    // a block of bits may not complete any character, so keep going until one does
+    while( mCharacters.empty() )
+    {
+        U32 bitCount = mBitStream.ReadBits( mBits, kBitBlockSize );
+        if( bitCount == 0 )
+        {
+            return false;
+        }
+        mDecoder.Decode( mBits, bitCount, mCharacters );
+    }
+    return true;
+}
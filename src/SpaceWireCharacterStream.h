@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include "SpaceWireBitStream.h"
+#include "SpaceWireCharacterDecoder.h"
+
+// decodes the characters of a data/strobe pair on demand, one at a time
+//
+// used for the reverse direction of a link, which is read alongside the main decode so its
+// characters can be merged in time order.
+class SpaceWireCharacterStream
+{
+  public:
+    // number of bits decoded at a time
+    static const U32 kBitBlockSize = 1024;
+
+    SpaceWireCharacterStream();
+
+    // start reading from the given channels (the sample rate is needed to detect disconnects, see
+    // SpaceWireBitStream::SetPairedEdgeSamples for pairedEdgeSamples)
+    void Reset( AnalyzerChannelData* data, AnalyzerChannelData* strobe, U32 sampleRateHz, U64 pairedEdgeSamples, bool desyncAfterError );
+
+    // return the next character without consuming it, or NULL at the end of the data
+    const DecodedCharacterStruct* Peek()
+    {
+        if( mNext == mCharacters.size() && !Fill() )
+        {
+            return NULL;
+        }
+        return &mCharacters[ mNext ];
+    }
+    // consume the character returned by Peek()
+    void Pop()
+    {
+        ++mNext;
+    }
+
+    // return the number of edges read and of channel calls made (instrumented builds only)
+    U64 GetEdgeCount() const
+    {
+        return mDataEdges.GetEdgeCount() + mStrobeEdges.GetEdgeCount();
+    }
+    U64 GetSdkCallCount() const
+    {
+        return mDataEdges.GetSdkCallCount() + mStrobeEdges.GetSdkCallCount();
+    }
+
+  protected:
+    // decode more characters, returns false at the end of the data
+    bool Fill();
+
+    SpaceWireChannelEdgeSource mDataEdges;
+    SpaceWireChannelEdgeSource mStrobeEdges;
+    SpaceWireBitStream mBitStream;
+    SpaceWireCharacterDecoder mDecoder;
+
+    RecoveredBitStruct mBits[ kBitBlockSize ];
+    std::vector<DecodedCharacterStruct> mCharacters;
+    // index of the next character in mCharacters
+    size_t mNext;
+};
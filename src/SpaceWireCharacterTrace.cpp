@@ -0,0 +1,196 @@
+#include "SpaceWireCharacterTrace.h"
+
+namespace
+{
+    // head bits below the character value
+    const U32 kHeadValueShift = 4;
+    const U32 kHeadHasGap = 1 << 3;
+    const U32 kHeadHasLength = 1 << 2;
+    const U32 kHeadTypeMask = 0x3;
+
+    // variable length integers hold 7 bits per byte, least significant first, with the top bit
+    // set on every byte but the last
+    U8* WriteVarint( U8* write, U64 value )
+    {
+        while( value >= 0x80 )
+        {
+            *write++ = ( U8 )( value | 0x80 );
+            value >>= 7;
+        }
+        *write++ = ( U8 )value;
+        return write;
+    }
+
+    const U8* ReadVarint( const U8* read, U64& value )
+    {
+        value = 0;
+        U32 shift = 0;
+        U8 byte;
+        do
+        {
+            byte = *read++;
+            value |= ( U64 )( byte & 0x7F ) << shift;
+            shift += 7;
+        } while( byte & 0x80 );
+        return read;
+    }
+}
+
+SpaceWireCharacterTrace::SpaceWireCharacterTrace()
+{
+    Clear();
+}
+
+void SpaceWireCharacterTrace::Clear()
+{
+    mChunks.clear();
+    mChunkUsed.clear();
+    mWrite = NULL;
+    mChunkEnd = NULL;
+    mCount = 0;
+    mOverflow = false;
+    mLastEndingSample = 0;
+    for( U32 i = 0; i < 4; ++i )
+    {
+        mLastLength[ i ] = 0;
+    }
+}
+
+void SpaceWireCharacterTrace::Grow()
+{
+    if( !mChunks.empty() )
+    {
+        mChunkUsed.back() = ( U32 )( mWrite - mChunks.back().get() );
+    }
+    mChunks.emplace_back( new U8[ kChunkSize ] );
+    mChunkUsed.push_back( 0 );
+    mWrite = mChunks.back().get();
+    mChunkEnd = mWrite + kChunkSize;
+}
+
+void SpaceWireCharacterTrace::Append( const DecodedCharacterStruct* characters, size_t count )
+{
+    if( mOverflow )
+    {
+        return;
+    }
+
+    for( const DecodedCharacterStruct* it = characters; it != characters + count; ++it )
+    {
+        if( ( size_t )( mChunkEnd - mWrite ) < kMaxCharacterSize )
+        {
+            if( GetSize() >= kMaxSize )
+            {
+                // a partial trace is no use, so give the memory back
+                Clear();
+                mOverflow = true;
+                return;
+            }
+            Grow();
+        }
+
+        // characters normally follow on from the previous one, at the same length as the last
+        // character of their type (differences are stored as unsigned, so they may wrap)
+        U64 gap = it->startingSample - mLastEndingSample - 1;
+        U64 length = it->endingSample - it->startingSample;
+        U32 head = ( ( U32 )it->value << kHeadValueShift ) | ( it->type & kHeadTypeMask );
+        if( gap != 0 )
+        {
+            head |= kHeadHasGap;
+        }
+        if( length != mLastLength[ it->type & kHeadTypeMask ] )
+        {
+            head |= kHeadHasLength;
+        }
+
+        mWrite = WriteVarint( mWrite, head );
+        if( head & kHeadHasGap )
+        {
+            mWrite = WriteVarint( mWrite, gap );
+        }
+        if( head & kHeadHasLength )
+        {
+            mWrite = WriteVarint( mWrite, length );
+            mLastLength[ it->type & kHeadTypeMask ] = length;
+        }
+        mLastEndingSample = it->endingSample;
+    }
+
+    mCount += count;
+    if( !mChunks.empty() )
+    {
+        mChunkUsed.back() = ( U32 )( mWrite - mChunks.back().get() );
+    }
+}
+
+SpaceWireCharacterTrace::Reader::Reader()
+{
+    Reset( NULL );
+}
+
+void SpaceWireCharacterTrace::Reader::Reset( const SpaceWireCharacterTrace* trace )
+{
+    mTrace = trace;
+    mChunk = 0;
+    mRead = NULL;
+    mChunkEnd = NULL;
+    mRemaining = ( trace != NULL ) ? trace->mCount : 0;
+    if( mRemaining != 0 )
+    {
+        mRead = trace->mChunks[ 0 ].get();
+        mChunkEnd = mRead + trace->mChunkUsed[ 0 ];
+    }
+    mHasNext = false;
+    mLastEndingSample = 0;
+    for( U32 i = 0; i < 4; ++i )
+    {
+        mLastLength[ i ] = 0;
+    }
+}
+
+bool SpaceWireCharacterTrace::Reader::ReadNext()
+{
+    if( mRemaining == 0 )
+    {
+        return false;
+    }
+    if( mRead == mChunkEnd )
+    {
+        ++mChunk;
+        mRead = mTrace->mChunks[ mChunk ].get();
+        mChunkEnd = mRead + mTrace->mChunkUsed[ mChunk ];
+    }
+
+    U64 head;
+    mRead = ReadVarint( mRead, head );
+    U64 gap = 0;
+    if( head & kHeadHasGap )
+    {
+        mRead = ReadVarint( mRead, gap );
+    }
+    U8 type = ( U8 )( head & kHeadTypeMask );
+    if( head & kHeadHasLength )
+    {
+        mRead = ReadVarint( mRead, mLastLength[ type ] );
+    }
+
+    mNext.type = type;
+    mNext.value = ( U8 )( head >> kHeadValueShift );
+    mNext.startingSample = mLastEndingSample + 1 + gap;
+    mNext.endingSample = mNext.startingSample + mLastLength[ type ];
+    mLastEndingSample = mNext.endingSample;
+    mHasNext = true;
+    --mRemaining;
+    return true;
+}
+
+U32 SpaceWireCharacterTrace::Reader::Read( DecodedCharacterStruct* characters, U32 maxCount )
+{
+    U32 count = 0;
+    while( count < maxCount && ( mHasNext || ReadNext() ) )
+    {
+        characters[ count++ ] = mNext;
+        mHasNext = false;
+    }
+    return count;
+}
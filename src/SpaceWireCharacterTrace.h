@@ -0,0 +1,110 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+#include "SpaceWireCharacterDecoder.h"
+
+// compact record of the characters of one decode, from which the frames can be rebuilt without
+// going back through the edges
+//
+// each character starts with a variable length integer holding its type and value and two flags,
+// followed by its distance from the end of the previous character if that isn't one sample, and
+// its length in samples if that differs from the previous character of the same type.  at a
+// steady bit rate a control character takes one byte and a data character two.
+class SpaceWireCharacterTrace
+{
+  public:
+    // size of each chunk in bytes
+    static const U32 kChunkSize = 1 << 20;
+    // longest encoding of a character (a two byte head and two 10 byte integers)
+    static const U32 kMaxCharacterSize = 22;
+    // stop recording beyond this size, the trace is unusable after that
+    static const U64 kMaxSize = ( U64 )128 << 20;
+
+    SpaceWireCharacterTrace();
+
+    // forget all characters
+    void Clear();
+
+    // add characters in the order they were decoded
+    void Append( const DecodedCharacterStruct* characters, size_t count );
+
+    // return false if characters were dropped because the trace grew too large
+    bool IsComplete() const
+    {
+        return !mOverflow;
+    }
+    // return the number of characters, and the memory they take
+    U64 GetCount() const
+    {
+        return mCount;
+    }
+    U64 GetSize() const
+    {
+        return ( U64 )mChunks.size() * kChunkSize;
+    }
+
+    // reads the characters of a trace back in order
+    class Reader
+    {
+      public:
+        Reader();
+
+        // start from the first character of trace (which must not change while it is read)
+        void Reset( const SpaceWireCharacterTrace* trace );
+
+        // return the next character without consuming it, or NULL after the last one
+        const DecodedCharacterStruct* Peek()
+        {
+            if( !mHasNext && !ReadNext() )
+            {
+                return NULL;
+            }
+            return &mNext;
+        }
+        // consume the character returned by Peek()
+        void Pop()
+        {
+            mHasNext = false;
+        }
+
+        // copy up to maxCount characters, returns 0 after the last one
+        U32 Read( DecodedCharacterStruct* characters, U32 maxCount );
+
+      protected:
+        // decode the next character into mNext, returns false after the last one
+        bool ReadNext();
+
+        const SpaceWireCharacterTrace* mTrace;
+        // chunk and byte of the next encoded character, and characters left
+        size_t mChunk;
+        const U8* mRead;
+        const U8* mChunkEnd;
+        U64 mRemaining;
+
+        DecodedCharacterStruct mNext;
+        bool mHasNext;
+        // ending sample of the previous character and length of each type, as when written
+        U64 mLastEndingSample;
+        U64 mLastLength[ 4 ];
+    };
+
+  protected:
+    // start a new chunk
+    void Grow();
+
+    std::vector<std::unique_ptr<U8[]>> mChunks;
+    // bytes used in each chunk (the last one is updated after each Append)
+    std::vector<U32> mChunkUsed;
+    U8* mWrite;
+    U8* mChunkEnd;
+    U64 mCount;
+    bool mOverflow;
+
+    // ending sample of the previous character, and the last length in samples of each type
+    U64 mLastEndingSample;
+    U64 mLastLength[ 4 ];
+};
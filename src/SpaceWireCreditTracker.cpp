@@ -0,0 +1,97 @@
+#include "SpaceWireCreditTracker.h"
+#include "SpaceWireAnalyzer.h"
+
+SpaceWireCreditTracker::SpaceWireCreditTracker()
+{
+    Reset();
+}
+
+void SpaceWireCreditTracker::Reset()
+{
+    for( U32 i = 0; i < kDirectionCount; ++i )
+    {
+        mDirections[ i ].stallSamples = 0;
+        Desync( ( DirectionEnum )i );
+    }
+}
+
+void SpaceWireCreditTracker::Desync( DirectionEnum direction )
+{
+    DirectionStruct& d = mDirections[ direction ];
+    d.balance = 0;
+    d.escPrefix = false;
+    d.packetOpen = false;
+    d.stalled = false;
+    Restart( d );
+}
+
+void SpaceWireCreditTracker::Restart( DirectionStruct& direction )
+{
+    direction.minBalance = direction.balance;
+    direction.maxBalance = direction.balance;
+}
+
+SpaceWireCreditTracker::EventEnum SpaceWireCreditTracker::AddCharacter( DirectionEnum direction, bool controlChar, U8 value,
+                                                                        U64 startingSample, DirectionEnum& affected )
+{
+    DirectionStruct& sender = mDirections[ direction ];
+
+    // ESC + anything is an L-char sequence (NULL, timecode or error) which uses no credit
+    if( sender.escPrefix )
+    {
+        sender.escPrefix = false;
+        return kEventNone;
+    }
+    if( controlChar && value == SpaceWireAnalyzer::kControlEsc )
+    {
+        sender.escPrefix = true;
+        return kEventNone;
+    }
+
+    if( controlChar && value == SpaceWireAnalyzer::kControlFct )
+    {
+        // an FCT grants credit to the other direction
+        affected = ( direction == kDirectionForward ) ? kDirectionReverse : kDirectionForward;
+        DirectionStruct& receiver = mDirections[ affected ];
+        receiver.balance += kCreditPerFct;
+        if( receiver.stalled )
+        {
+            receiver.stalled = false;
+            receiver.stallSamples += startingSample - receiver.stallStartingSample;
+        }
+        if( receiver.balance > receiver.maxBalance )
+        {
+            receiver.maxBalance = receiver.balance;
+            if( receiver.maxBalance - receiver.minBalance > kMaxCredit )
+            {
+                Restart( receiver );
+                return kEventOverflow;
+            }
+        }
+        return kEventNone;
+    }
+
+    // an N-char uses one credit
+    affected = direction;
+    sender.packetOpen = !controlChar;
+    --sender.balance;
+    EventEnum event = kEventNone;
+    if( sender.balance < sender.minBalance )
+    {
+        sender.minBalance = sender.balance;
+        if( sender.maxBalance - sender.minBalance > kMaxCredit )
+        {
+            Restart( sender );
+            event = kEventUnderflow;
+        }
+    }
+
+    // with the highest possible starting credit, the credit is now 56 - maxBalance + balance
+    // if that is zero the sender can't continue the packet until it gets an FCT
+    if( sender.packetOpen && !sender.stalled && sender.balance + kMaxCredit == sender.maxBalance )
+    {
+        sender.stalled = true;
+        sender.stallStartingSample = startingSample;
+    }
+    return event;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <LogicPublicTypes.h>
+
+// tracks flow control credit in both directions of a link
+//
+// every FCT sent in one direction allows the other direction to send 8 more N-chars (data
+// characters, EOP and EEP), up to 56 outstanding.  a capture rarely starts at link start-up, so the
+// credit at the start is unknown: the tracker keeps the balance of credit granted minus credit used
+// since the start, and the range of starting credits that keep the credit within 0..56.  when no
+// starting credit fits any more, an N-char was sent without credit (underflow) or an FCT was sent
+// with no room for it (overflow), and the tracker starts over from the offending character.
+class SpaceWireCreditTracker
+{
+  public:
+    // link directions
+    enum DirectionEnum
+    {
+        // the data/strobe channels of the analyzer
+        kDirectionForward,
+        // the reverse data/strobe channels
+        kDirectionReverse,
+        kDirectionCount,
+    };
+
+    // result of adding a character
+    enum EventEnum
+    {
+        kEventNone,
+        // the direction sent an N-char without credit
+        kEventUnderflow,
+        // the direction was granted more than the maximum credit
+        kEventOverflow,
+    };
+
+    // credit granted by one FCT, and the most that can be outstanding
+    static const S64 kCreditPerFct = 8;
+    static const S64 kMaxCredit = 56;
+
+    SpaceWireCreditTracker();
+
+    // forget all state and counters
+    void Reset();
+    // forget the state of a direction after it lost synchronization
+    void Desync( DirectionEnum direction );
+
+    // add a character sent in a direction
+    // returns the credit event it caused, and sets affected to the direction whose credit was wrong
+    EventEnum AddCharacter( DirectionEnum direction, bool controlChar, U8 value, U64 startingSample,
+                            DirectionEnum& affected );
+
+    // return the number of samples a direction spent in the middle of a packet without credit
+    // (a stall which is still going on counts up to currentSample)
+    U64 GetStallSamples( DirectionEnum direction, U64 currentSample ) const
+    {
+        const DirectionStruct& d = mDirections[ direction ];
+        if( d.stalled && currentSample > d.stallStartingSample )
+        {
+            return d.stallSamples + currentSample - d.stallStartingSample;
+        }
+        return d.stallSamples;
+    }
+
+  protected:
+    struct DirectionStruct
+    {
+        // credit granted minus credit used since the last restart
+        S64 balance;
+        // lowest and highest balance since the last restart
+        S64 minBalance;
+        S64 maxBalance;
+        // true if the previous character sent was an ESC
+        bool escPrefix;
+        // true between the first data character of a packet and its EOP/EEP
+        bool packetOpen;
+        // true while the credit is known to be zero in the middle of a packet
+        bool stalled;
+        U64 stallStartingSample;
+        U64 stallSamples;
+    };
+
+    // forget the credit of a direction, starting over from its current balance
+    static void Restart( DirectionStruct& direction );
+
+    DirectionStruct mDirections[ kDirectionCount ];
+};
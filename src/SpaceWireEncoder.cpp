@@ -0,0 +1,137 @@
+#include "SpaceWireEncoder.h"
+#include "SpaceWireAnalyzer.h"
+
+SpaceWireEncoder::SpaceWireEncoder() : mBitSamples( 1 ), mBitFraction( 0 )
+{
+    Reset( 0 );
+}
+
+void SpaceWireEncoder::Reset( U64 firstSample )
+{
+    mData = false;
+    mStrobe = false;
+    mPreviousOnes = 0;
+    mCorruptParity = false;
+    mSample = firstSample;
+    mFraction = 0;
+    mBitCount = 0;
+    ClearEdges();
+}
+
+void SpaceWireEncoder::SetBitRate( U32 sampleRateHz, U64 bitRateBps )
+{
+    // samples per bit as 32.32 fixed point
+    U64 period = ( ( U64 )sampleRateHz << 32 ) / bitRateBps;
+    mBitSamples = period >> 32;
+    mBitFraction = ( U32 )period;
+}
+
+void SpaceWireEncoder::AddControl( U8 code )
+{
+    AddCharacter( true, code, 2, 4 );
+}
+
+namespace
+{
+    // data is sent LSB first
+    U32 DataPayload( U8 value )
+    {
+        U32 payload = 0;
+        for( U32 i = 0; i < 8; ++i )
+        {
+            payload |= ( ( value >> i ) & 1 ) << ( 7 - i );
+        }
+        return payload;
+    }
+}
+
+void SpaceWireEncoder::AddData( U8 value )
+{
+    AddCharacter( false, DataPayload( value ), 8, 10 );
+}
+
+void SpaceWireEncoder::AddNull()
+{
+    AddControl( SpaceWireAnalyzer::kControlEsc );
+    AddControl( SpaceWireAnalyzer::kControlFct );
+}
+
+void SpaceWireEncoder::AddTimecode( U8 value )
+{
+    AddControl( SpaceWireAnalyzer::kControlEsc );
+    AddData( value );
+}
+
+void SpaceWireEncoder::AddCoincidentEdges()
+{
+    mData = !mData;
+    mStrobe = !mStrobe;
+    mDataEdges.push_back( mSample );
+    mStrobeEdges.push_back( mSample );
+    NextBit();
+    ++mBitCount;
+}
+
+void SpaceWireEncoder::AddTruncatedData( U8 value, U32 count )
+{
+    AddCharacter( false, DataPayload( value ), 8, count );
+}
+
+void SpaceWireEncoder::Disconnect( U64 restartSample )
+{
+    if( mData )
+    {
+        mData = false;
+        mDataEdges.push_back( mSample );
+    }
+    if( mStrobe )
+    {
+        mStrobe = false;
+        mStrobeEdges.push_back( mSample );
+    }
+    mPreviousOnes = 0;
+    mCorruptParity = false;
+    mSample = ( restartSample > mSample ) ? restartSample : mSample + 1;
+    mFraction = 0;
+}
+
+void SpaceWireEncoder::AddCharacter( bool control, U32 payload, U32 count, U32 sentBits )
+{
+    // parity is odd over the previous payload, this parity bit and this data-control flag
+    U32 parity = ( mPreviousOnes + ( control ? 1 : 0 ) + ( mCorruptParity ? 0 : 1 ) ) & 1;
+    mCorruptParity = false;
+    U32 ones = 0;
+    for( U32 i = 0; i < count; ++i )
+    {
+        ones += ( payload >> i ) & 1;
+    }
+    mPreviousOnes = ones;
+    U32 bits = ( parity << ( count + 1 ) ) | ( ( control ? 1 : 0 ) << count ) | payload;
+    AddBits( bits >> ( count + 2 - sentBits ), sentBits );
+}
+
+void SpaceWireEncoder::AddBits( U32 bits, U32 count )
+{
+    for( U32 i = count; i-- > 0; )
+    {
+        bool value = ( ( bits >> i ) & 1 ) != 0;
+        if( value != mData )
+        {
+            mData = value;
+            mDataEdges.push_back( mSample );
+        }
+        else
+        {
+            mStrobe = !mStrobe;
+            mStrobeEdges.push_back( mSample );
+        }
+        NextBit();
+    }
+    mBitCount += count;
+}
+
+void SpaceWireEncoder::ClearEdges()
+{
+    mDataEdges.clear();
+    mStrobeEdges.clear();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+// encodes characters into the data and strobe edges of one direction of a link
+//
+// both lines start low.  every bit toggles data if its value differs from the line, strobe
+// otherwise.  edges are appended to two lists of sample numbers which the caller takes in bulk,
+// and bits may last a fractional number of samples.
+class SpaceWireEncoder
+{
+  public:
+    SpaceWireEncoder();
+
+    // start over with both lines low and the next bit at firstSample
+    void Reset( U64 firstSample );
+    // set the length of the following bits
+    void SetBitRate( U32 sampleRateHz, U64 bitRateBps );
+
+    // add a control character (one of SpaceWireAnalyzer::ControlCharacterEnum)
+    void AddControl( U8 code );
+    // add a data character
+    void AddData( U8 value );
+    // add ESC followed by FCT
+    void AddNull();
+    // add ESC followed by a data character
+    void AddTimecode( U8 value );
+    // add bits as they are, oldest bit most significant (this does not change the parity state)
+    void AddBits( U32 bits, U32 count );
+
+    // faults
+    // send the next character with the wrong parity
+    void CorruptNextParity()
+    {
+        mCorruptParity = true;
+    }
+    // toggle data and strobe on the same sample, taking one bit time
+    void AddCoincidentEdges();
+    // send only the first count bits (parity, flag and data LSB first) of a data character
+    void AddTruncatedData( U8 value, U32 count );
+    // stop sending as a transmitter does when its link resets: both lines go low one bit after
+    // the last one, and the next bit (the start of a new link) is at restartSample
+    void Disconnect( U64 restartSample );
+
+    // return the first sample of the next bit
+    U64 GetSample() const
+    {
+        return mSample;
+    }
+    // return the number of bits added since the last Reset
+    U64 GetBitCount() const
+    {
+        return mBitCount;
+    }
+
+    // edges added since the last ClearEdges, in sample order
+    const std::vector<U64>& GetDataEdges() const
+    {
+        return mDataEdges;
+    }
+    const std::vector<U64>& GetStrobeEdges() const
+    {
+        return mStrobeEdges;
+    }
+    void ClearEdges();
+
+  protected:
+    // add a character whose payload is count bits of payload (oldest bit most significant),
+    // sending only its first sentBits bits
+    void AddCharacter( bool control, U32 payload, U32 count, U32 sentBits );
+    // advance to the next bit
+    void NextBit()
+    {
+        U32 fraction = mFraction + mBitFraction;
+        mSample += mBitSamples + ( ( fraction < mFraction ) ? 1 : 0 );
+        mFraction = fraction;
+    }
+
+    // current line levels
+    bool mData;
+    bool mStrobe;
+    // ones in the payload of the previous character, for the parity of the next one
+    U32 mPreviousOnes;
+    bool mCorruptParity;
+
+    // first sample of the next bit, and fraction of a sample in units of 2^-32
+    U64 mSample;
+    U32 mFraction;
+    // bit length in whole samples and in units of 2^-32 samples
+    U64 mBitSamples;
+    U32 mBitFraction;
+    U64 mBitCount;
+
+    std::vector<U64> mDataEdges;
+    std::vector<U64> mStrobeEdges;
+};
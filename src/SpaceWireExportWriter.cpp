@@ -0,0 +1,197 @@
+#include "SpaceWireExportWriter.h"
+
+static const char hexDigit[] = "0123456789ABCDEF";
+
+SpaceWireExportWriter::SpaceWireExportWriter()
+    : mUsed( 0 ), mFile( NULL ), mTriggerSample( 0 ), mSampleRateHz( 1 ), mTimeDigits( 0 ), mTimeScale( 1 )
+{
+}
+
+SpaceWireExportWriter::~SpaceWireExportWriter()
+{
+    Close();
+}
+
+bool SpaceWireExportWriter::Open( const char* path )
+{
+    Close();
+    mFile = fopen( path, "wb" );
+    if( mFile == NULL )
+    {
+        return false;
+    }
+    // the buffer is kept between exports
+    mBuffer.resize( kBufferSize );
+    mUsed = 0;
+    return true;
+}
+
+void SpaceWireExportWriter::Close()
+{
+    if( mFile != NULL )
+    {
+        Flush();
+        fclose( mFile );
+        mFile = NULL;
+    }
+}
+
+void SpaceWireExportWriter::Flush()
+{
+    if( mUsed != 0 )
+    {
+        fwrite( mBuffer.data(), 1, mUsed, mFile );
+        mUsed = 0;
+    }
+}
+
+void SpaceWireExportWriter::Write( const char* text, size_t length )
+{
+    while( length != 0 )
+    {
+        if( mUsed == mBuffer.size() )
+        {
+            Flush();
+        }
+        size_t n = mBuffer.size() - mUsed;
+        if( n > length )
+        {
+            n = length;
+        }
+        memcpy( &mBuffer[ mUsed ], text, n );
+        mUsed += n;
+        text += n;
+        length -= n;
+    }
+}
+
+void SpaceWireExportWriter::WriteU16( U16 value )
+{
+    Reserve( 2 );
+    mBuffer[ mUsed++ ] = ( char )( value & 0xFF );
+    mBuffer[ mUsed++ ] = ( char )( value >> 8 );
+}
+
+void SpaceWireExportWriter::WriteU32( U32 value )
+{
+    Reserve( 4 );
+    for( U32 i = 0; i < 4; ++i )
+    {
+        mBuffer[ mUsed++ ] = ( char )( value & 0xFF );
+        value >>= 8;
+    }
+}
+
+void SpaceWireExportWriter::WriteUnsigned( U64 value )
+{
+    // digits come out in reverse order
+    char digits[ 20 ];
+    U32 count = 0;
+    do
+    {
+        digits[ count++ ] = '0' + ( char )( value % 10 );
+        value /= 10;
+    } while( value != 0 );
+
+    Reserve( count );
+    while( count != 0 )
+    {
+        mBuffer[ mUsed++ ] = digits[ --count ];
+    }
+}
+
+void SpaceWireExportWriter::WritePadded( U64 value, U32 digits )
+{
+    Reserve( digits );
+    for( U32 i = digits; i != 0; --i )
+    {
+        mBuffer[ mUsed + i - 1 ] = '0' + ( char )( value % 10 );
+        value /= 10;
+    }
+    mUsed += digits;
+}
+
+void SpaceWireExportWriter::WriteHex( U64 value, U32 digits )
+{
+    Reserve( digits );
+    for( U32 i = digits; i != 0; --i )
+    {
+        mBuffer[ mUsed + i - 1 ] = hexDigit[ value & 0xF ];
+        value >>= 4;
+    }
+    mUsed += digits;
+}
+
+void SpaceWireExportWriter::WriteBinary( U64 value, U32 bits )
+{
+    Reserve( bits );
+    for( U32 i = bits; i != 0; --i )
+    {
+        mBuffer[ mUsed + i - 1 ] = '0' + ( char )( value & 1 );
+        value >>= 1;
+    }
+    mUsed += bits;
+}
+
+void SpaceWireExportWriter::WriteHexBytes( const U8* data, U64 count )
+{
+    while( count != 0 )
+    {
+        U64 n = ( mBuffer.size() - mUsed ) / 2;
+        if( n == 0 )
+        {
+            Flush();
+            continue;
+        }
+        if( n > count )
+        {
+            n = count;
+        }
+        char* out = &mBuffer[ mUsed ];
+        for( U64 i = 0; i < n; ++i )
+        {
+            *out++ = hexDigit[ data[ i ] >> 4 ];
+            *out++ = hexDigit[ data[ i ] & 0xF ];
+        }
+        mUsed += 2 * n;
+        data += n;
+        count -= n;
+    }
+}
+
+void SpaceWireExportWriter::SetTimeBase( U64 triggerSample, U32 sampleRateHz )
+{
+    mTriggerSample = triggerSample;
+    mSampleRateHz = ( sampleRateHz != 0 ) ? sampleRateHz : 1;
+
+    // enough decimal places to resolve one sample, up to nanoseconds
+    mTimeDigits = 0;
+    mTimeScale = 1;
+    while( mTimeScale < mSampleRateHz && mTimeDigits < 9 )
+    {
+        ++mTimeDigits;
+        mTimeScale *= 10;
+    }
+}
+
+void SpaceWireExportWriter::WriteTime( S64 sample )
+{
+    U64 delta;
+    if( sample < ( S64 )mTriggerSample )
+    {
+        WriteChar( '-' );
+        delta = mTriggerSample - sample;
+    }
+    else
+    {
+        delta = sample - mTriggerSample;
+    }
+
+    WriteUnsigned( delta / mSampleRateHz );
+    if( mTimeDigits != 0 )
+    {
+        WriteChar( '.' );
+        // remainder is below 2^32 and the scale at most 10^9, so this cannot overflow
+        WritePadded( ( delta % mSampleRateHz ) * mTimeScale / mSampleRateHz, mTimeDigits );
+    }
+}
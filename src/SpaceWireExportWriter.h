@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+// buffered writer for large text and binary exports
+//
+// output is formatted straight into one large buffer which is written to the file whenever it fills
+// up, so exporting a row or record costs no stream operations or temporary strings.
+class SpaceWireExportWriter
+{
+  public:
+    // size of the output buffer in bytes
+    static const U32 kBufferSize = 1 << 20;
+
+    SpaceWireExportWriter();
+    ~SpaceWireExportWriter();
+
+    // start writing to a new file, returns false if it cannot be created
+    bool Open( const char* path );
+    // write out any buffered text and close the file
+    void Close();
+
+    // write a string
+    void Write( const char* text, size_t length );
+    void Write( const char* text )
+    {
+        Write( text, strlen( text ) );
+    }
+    // write raw bytes
+    void WriteBytes( const void* data, size_t length )
+    {
+        Write( ( const char* )data, length );
+    }
+    // write little-endian integers
+    void WriteU16( U16 value );
+    void WriteU32( U32 value );
+    // write a single character
+    void WriteChar( char c )
+    {
+        Reserve( 1 );
+        mBuffer[ mUsed++ ] = c;
+    }
+    // write an unsigned decimal number
+    void WriteUnsigned( U64 value );
+    // write a decimal number padded with zeros to the given number of digits
+    void WritePadded( U64 value, U32 digits );
+    // write the low digits of value in hexadecimal
+    void WriteHex( U64 value, U32 digits );
+    // write the low bits of value in binary
+    void WriteBinary( U64 value, U32 bits );
+    // write bytes as consecutive pairs of hex digits
+    void WriteHexBytes( const U8* data, U64 count );
+
+    // set the sample and rate that WriteTime is relative to
+    void SetTimeBase( U64 triggerSample, U32 sampleRateHz );
+    // write the time of a sample in seconds relative to the trigger
+    void WriteTime( S64 sample );
+
+  protected:
+    // make room for at least count more characters
+    void Reserve( size_t count )
+    {
+        if( mUsed + count > mBuffer.size() )
+        {
+            Flush();
+        }
+    }
+    // write the buffer to the file
+    void Flush();
+
+    std::vector<char> mBuffer;
+    size_t mUsed;
+    FILE* mFile;
+
+    U64 mTriggerSample;
+    U32 mSampleRateHz;
+    // number of decimal places written by WriteTime, and 10 to that power
+    U32 mTimeDigits;
+    U64 mTimeScale;
+};
@@ -0,0 +1,714 @@
+#include <thread>
+#include <vector>
+
+#include "SpaceWireFrameBuilder.h"
+#include "SpaceWireAnalyzer.h"
+#include "SpaceWireAnalyzerSettings.h"
+
+SpaceWireFrameSink::~SpaceWireFrameSink()
+{
+}
+
+SpaceWireFrameBuilder::SpaceWireFrameBuilder( SpaceWireFrameSink& sink, SpaceWireInstrumentation& instrumentation )
+    : mSink( sink ), mInstrumentation( instrumentation ), mSettings( NULL ), mTrace( NULL ), mReverseTrace( NULL ), mReplaying( false ),
+      mHasReverse( false ), mReverse( NULL ), mPacketArena( NULL ), mRunCount( 0 )
+{
+}
+
+void SpaceWireFrameBuilder::Reset( const SpaceWireAnalyzerSettings* settings, U32 sampleRateHz, U64 firstSample,
+                                   SpaceWirePacketArena* packetArena, SpaceWireCharacterStream* reverse )
+{
+    mSettings = settings;
+
+    // the reverse direction is only needed to track flow control credit
+    mReverse = reverse;
+    mHasReverse = reverse != NULL;
+    mCredit.Reset();
+    mCreditSample = 0;
+    mReversePacket.clear();
+    mReverseEscPrefix = false;
+    mRmapMatcher.Reset();
+
+    mUncommittedFrames = 0;
+    mCommitSampleSpan = ( U64 )( sampleRateHz * kCommitSpanSeconds );
+    mNextCommitSample = firstSample + mCommitSampleSpan;
+
+    mPacketArena = packetArena;
+    mPacketArena->SetDigestMode( mSettings->mPayloadMode == SpaceWireAnalyzerSettings::kPayloadDigest );
+
+    mLinkRate.Reset( sampleRateHz );
+    mStatistics.Reset();
+    mTimecodeStatistics.Reset();
+
+    // reset state variables to desynchronized state
+    mRunCount = 0;
+    Desync();
+    mCharacters.clear();
+}
+
+void SpaceWireFrameBuilder::SetRecording( SpaceWireCharacterTrace* trace, SpaceWireCharacterTrace* reverseTrace )
+{
+    mTrace = trace;
+    mReverseTrace = reverseTrace;
+}
+
+void SpaceWireFrameBuilder::Desync()
+{
+    FlushRun();
+    mLinkRate.Restart();
+    mPacketArena->DiscardPacket();
+    mSink.CancelPacket();
+    mEscPrefix = false;
+    mLastTimecode = 255;
+    mTimecodeStatistics.Restart();
+}
+
+void SpaceWireFrameBuilder::AddFrame( U64 mData1, U64 mData2, U8 mType, U8 mFlags, U64 mStartingSampleInclusive,
+                                      U64 mEndingSampleInclusive )
+{
+    // a run ends at the next frame
+    if( mRunCount != 0 )
+    {
+        FlushRun();
+    }
+
+    Frame frame;
+    frame.mData1 = mData1;
+    frame.mData2 = mData2;
+    frame.mType = mType;
+    frame.mFlags = mFlags;
+    frame.mStartingSampleInclusive = mStartingSampleInclusive;
+    frame.mEndingSampleInclusive = mEndingSampleInclusive;
+    mSink.AddFrame( frame );
+    mInstrumentation.Count( SpaceWireInstrumentation::kCounterFrames );
+    mFramesAdded.Add( 1 );
+
+    // commit in batches so the UI isn't woken up for every frame
+    ++mUncommittedFrames;
+    if( mUncommittedFrames >= kCommitFrameCount || mEndingSampleInclusive >= mNextCommitSample )
+    {
+        CommitFrames();
+        mNextCommitSample = mEndingSampleInclusive + mCommitSampleSpan;
+    }
+}
+
+void SpaceWireFrameBuilder::CommitIfDue( U64 sample )
+{
+    // frames can be sparse (e.g. with NULLs hidden), so the decode loops check the span too
+    if( sample >= mNextCommitSample )
+    {
+        CommitFrames();
+        mNextCommitSample = sample + mCommitSampleSpan;
+    }
+}
+
+void SpaceWireFrameBuilder::AddRun( U8 type, U64 startingSample, U64 endingSample )
+{
+    if( !mSettings->mCollapseRuns )
+    {
+        AddFrame( SpaceWireAnalyzer::kControlFct, 0, type, 0, startingSample, endingSample );
+        return;
+    }
+    if( mRunCount != 0 && mRunType != type )
+    {
+        FlushRun();
+    }
+    if( mRunCount == 0 )
+    {
+        mRunType = type;
+        mRunStartingSample = startingSample;
+    }
+    mRunEndingSample = endingSample;
+    ++mRunCount;
+}
+
+void SpaceWireFrameBuilder::FlushRun()
+{
+    if( mRunCount != 0 )
+    {
+        // a single character is shown as it would be without collapsing
+        U64 count = ( mRunCount > 1 ) ? mRunCount : 0;
+        mRunCount = 0;
+        AddFrame( SpaceWireAnalyzer::kControlFct, count, mRunType, 0, mRunStartingSample, mRunEndingSample );
+    }
+}
+
+U64 SpaceWireFrameBuilder::AddPacketFrame( U8 type, U8 flags, U8 endMarker, U64 endingSample )
+{
+    // frames since the last packet are not part of this one
+    mSink.CancelPacket();
+
+    U64 length = mPacketArena->GetOpenLength();
+    U64 handle = mPacketArena->FinishPacket();
+    AddFrame( handle, length, type, flags, mPacketDataStartingSample, endingSample );
+    return mSink.CommitPacket( handle, length, endMarker );
+}
+
+bool SpaceWireFrameBuilder::DecodeRmap( const U8* data, U64 storedLength, U64 length, RmapPacketStruct& packet )
+{
+    return mSettings->mDecodeRmap && SpaceWireRmap::Decode( data, storedLength, length, packet );
+}
+
+void SpaceWireFrameBuilder::MatchRmap( const RmapPacketStruct& packet, U64 packetId, U64 startingSample, U64 endingSample )
+{
+    // the transaction id and addresses can't be trusted without a good header
+    if( !packet.HasValidHeader() )
+    {
+        return;
+    }
+
+    if( packet.IsCommand() )
+    {
+        RmapTransactionStruct transaction;
+        transaction.command = packet;
+        transaction.replied = false;
+        transaction.commandPacketId = packetId;
+        transaction.replyPacketId = INVALID_RESULT_INDEX;
+        transaction.commandStartingSample = startingSample;
+        transaction.commandEndingSample = endingSample;
+        transaction.replyStartingSample = 0;
+        transaction.replyEndingSample = 0;
+
+        U64 transactionId = mSink.AddRmapTransaction( transaction );
+        if( packetId != INVALID_RESULT_INDEX )
+        {
+            mSink.AddPacketToTransaction( transactionId, packetId );
+        }
+        if( packet.WantsReply() )
+        {
+            mRmapMatcher.AddCommand( packet, transactionId );
+        }
+    }
+    else
+    {
+        U64 transactionId;
+        if( mRmapMatcher.MatchReply( packet, transactionId ) )
+        {
+            RmapTransactionStruct transaction = mSink.GetRmapTransaction( transactionId );
+            transaction.reply = packet;
+            transaction.replied = true;
+            transaction.replyPacketId = packetId;
+            transaction.replyStartingSample = startingSample;
+            transaction.replyEndingSample = endingSample;
+            mSink.SetRmapTransaction( transactionId, transaction );
+            if( packetId != INVALID_RESULT_INDEX )
+            {
+                mSink.AddPacketToTransaction( transactionId, packetId );
+            }
+        }
+    }
+}
+
+void SpaceWireFrameBuilder::CollectReversePacket( bool controlChar, U8 value, U64 startingSample, U64 endingSample )
+{
+    // ESC + anything is a NULL, timecode or escape error
+    bool escaped = mReverseEscPrefix;
+    mReverseEscPrefix = !escaped && controlChar && value == SpaceWireAnalyzer::kControlEsc;
+    if( escaped || mReverseEscPrefix )
+    {
+        return;
+    }
+
+    if( !controlChar )
+    {
+        if( mReversePacket.empty() )
+        {
+            mReversePacketStartingSample = startingSample;
+        }
+        mReversePacket.push_back( value );
+    }
+    else if( value == SpaceWireAnalyzer::kControlEop || value == SpaceWireAnalyzer::kControlEep )
+    {
+        RmapPacketStruct rmap;
+        if( value == SpaceWireAnalyzer::kControlEop && !mReversePacket.empty() &&
+            DecodeRmap( &mReversePacket[ 0 ], mReversePacket.size(), mReversePacket.size(), rmap ) )
+        {
+            MatchRmap( rmap, INVALID_RESULT_INDEX, mReversePacketStartingSample, endingSample );
+        }
+        mReversePacket.clear();
+    }
+}
+
+void SpaceWireFrameBuilder::CommitFrames()
+{
+    if( mUncommittedFrames != 0 )
+    {
+        LinkStatisticsStruct statistics = mStatistics.Get();
+        statistics.creditStallSamples[ SpaceWireCreditTracker::kDirectionForward ] =
+            mCredit.GetStallSamples( SpaceWireCreditTracker::kDirectionForward, mCreditSample );
+        statistics.creditStallSamples[ SpaceWireCreditTracker::kDirectionReverse ] =
+            mCredit.GetStallSamples( SpaceWireCreditTracker::kDirectionReverse, mCreditSample );
+        mSink.CommitFrames( statistics, mTimecodeStatistics.Get() );
+        mInstrumentation.Count( SpaceWireInstrumentation::kCounterCommits );
+        mUncommittedFrames = 0;
+    }
+}
+
+void SpaceWireFrameBuilder::DecodeTrace( const SpaceWireCharacterTrace& trace, const SpaceWireCharacterTrace& reverseTrace )
+{
+    SpaceWireCharacterTrace::Reader reader;
+    reader.Reset( &trace );
+    mReverseTraceReader.Reset( &reverseTrace );
+    mReplaying = true;
+
+    mCharacters.resize( kBitBlockSize );
+    while( true )
+    {
+        U32 count = reader.Read( mCharacters.data(), kBitBlockSize );
+        if( count == 0 )
+        {
+            break;
+        }
+        ProcessCharacters( mCharacters.data(), count );
+        CommitIfDue( mCharacters[ count - 1 ].endingSample );
+        mSink.ReportDecodeProgress( mCharacters[ count - 1 ].endingSample );
+    }
+    mCharacters.clear();
+    mReplaying = false;
+}
+
+void SpaceWireFrameBuilder::DecodeStream( SpaceWireBitStream& bitStream )
+{
+    mDecoder.Reset();
+    mDecoder.SetDesyncAfterError( mSettings->mDesyncAfterError );
+
+    while( true )
+    {
+        // read a block of bits from the merged data/strobe stream
+        mInstrumentation.StartTimer( SpaceWireInstrumentation::kTimerEdgeFetch );
+        U32 bitCount = bitStream.ReadBits( mBitBlock, kBitBlockSize );
+        mInstrumentation.StopTimer( SpaceWireInstrumentation::kTimerEdgeFetch );
+        if( bitCount == 0 )
+        {
+            break;
+        }
+        mInstrumentation.Count( SpaceWireInstrumentation::kCounterBits, bitCount );
+
+        mInstrumentation.StartTimer( SpaceWireInstrumentation::kTimerDecode );
+        mDecoder.Decode( mBitBlock, bitCount, mCharacters );
+        mInstrumentation.StopTimer( SpaceWireInstrumentation::kTimerDecode );
+        ProcessCharacters( mCharacters.data(), mCharacters.size() );
+        mCharacters.clear();
+
+        CommitIfDue( mBitBlock[ bitCount - 1 ].firstSample );
+        mSink.ReportDecodeProgress( mBitBlock[ bitCount - 1 ].firstSample );
+    }
+}
+
+void SpaceWireFrameBuilder::DecodeSegments( SpaceWireBitStream& bitStream )
+{
+    U32 threadCount = std::thread::hardware_concurrency();
+    mSegmentDecoder.Reset( threadCount, mSettings->mDesyncAfterError );
+
+    std::vector<RecoveredBitStruct> segment;
+    bool moreData = true;
+    while( moreData )
+    {
+        // read the next segment while earlier ones are being decoded
+        segment.resize( SpaceWireSegmentDecoder::kSegmentBits );
+        mInstrumentation.StartTimer( SpaceWireInstrumentation::kTimerEdgeFetch );
+        U32 bitCount = bitStream.ReadBits( segment.data(), SpaceWireSegmentDecoder::kSegmentBits );
+        mInstrumentation.StopTimer( SpaceWireInstrumentation::kTimerEdgeFetch );
+        mInstrumentation.Count( SpaceWireInstrumentation::kCounterBits, bitCount );
+        segment.resize( bitCount );
+        moreData = bitCount == SpaceWireSegmentDecoder::kSegmentBits;
+
+        if( bitCount != 0 )
+        {
+            if( mSegmentDecoder.IsFull() )
+            {
+                CollectSegment();
+            }
+            mSegmentDecoder.Submit( segment );
+        }
+    }
+
+    while( !mSegmentDecoder.IsEmpty() )
+    {
+        CollectSegment();
+    }
+}
+
+void SpaceWireFrameBuilder::CollectSegment()
+{
+    // the decode time is what this thread spends waiting for and stitching the segment
+    mInstrumentation.StartTimer( SpaceWireInstrumentation::kTimerDecode );
+    U64 lastSample = mSegmentDecoder.Collect( mCharacters );
+    mInstrumentation.StopTimer( SpaceWireInstrumentation::kTimerDecode );
+    ProcessCharacters( mCharacters.data(), mCharacters.size() );
+    mCharacters.clear();
+    CommitIfDue( lastSample );
+    mSink.ReportDecodeProgress( lastSample );
+}
+
+void SpaceWireFrameBuilder::DecodePipelined( SpaceWireBitStream& bitStream )
+{
+    mPipeline.Start( mSettings->mDesyncAfterError );
+    SpaceWirePipeline::StopGuard stopGuard( mPipeline );
+
+    // the channel data may only be read on this thread, so it recovers the bits and turns the
+    // characters into frames while the pipeline decodes the characters in between
+    mCharacters.resize( kBitBlockSize );
+    U32 bitCount = 0;
+    U32 bitsWritten = 0;
+    bool moreBits = true;
+    while( true )
+    {
+        if( moreBits && bitsWritten == bitCount )
+        {
+            mInstrumentation.StartTimer( SpaceWireInstrumentation::kTimerEdgeFetch );
+            mPipeline.StartStage( SpaceWirePipeline::kStageRecovery );
+            bitCount = bitStream.ReadBits( mBitBlock, kBitBlockSize );
+            mPipeline.StopStage( SpaceWirePipeline::kStageRecovery, bitCount );
+            mInstrumentation.StopTimer( SpaceWireInstrumentation::kTimerEdgeFetch );
+            mInstrumentation.Count( SpaceWireInstrumentation::kCounterBits, bitCount );
+            bitsWritten = 0;
+            if( bitCount == 0 )
+            {
+                moreBits = false;
+                mPipeline.CloseBits();
+            }
+        }
+        U32 written = mPipeline.WriteBits( mBitBlock + bitsWritten, bitCount - bitsWritten );
+        bitsWritten += written;
+
+        // once all bits are written, wait for the remaining characters
+        U32 count = ( moreBits ) ? mPipeline.TryReadCharacters( mCharacters.data(), kBitBlockSize )
+                                 : mPipeline.ReadCharacters( mCharacters.data(), kBitBlockSize );
+        if( count == 0 )
+        {
+            if( !moreBits )
+            {
+                break;
+            }
+            if( written == 0 )
+            {
+                // no room for bits and no characters yet.  the decode thread frees room as it
+                // takes its next block, right after writing the characters of this one, so
+                // waiting for room also catches those characters
+                mPipeline.WaitForBitSpace();
+            }
+            continue;
+        }
+        mPipeline.StartStage( SpaceWirePipeline::kStageEmit );
+        U64 framesAdded = mFramesAdded.Get();
+        ProcessCharacters( mCharacters.data(), count );
+        CommitIfDue( mCharacters[ count - 1 ].endingSample );
+        mPipeline.StopStage( SpaceWirePipeline::kStageEmit, mFramesAdded.Get() - framesAdded );
+        mSink.ReportDecodeProgress( mCharacters[ count - 1 ].endingSample );
+    }
+    mCharacters.clear();
+
+    // the decode thread times itself, and is done once the last character was read
+    mInstrumentation.AddSeconds( SpaceWireInstrumentation::kTimerDecode,
+                                 mPipeline.GetStageStats( SpaceWirePipeline::kStageDecode ).busySeconds );
+    for( U32 i = 0; i < SpaceWirePipeline::kStageCount; ++i )
+    {
+        SpaceWirePipeline::StageEnum stage = ( SpaceWirePipeline::StageEnum )i;
+        const SpaceWirePipeline::StageStatsStruct& stats = mPipeline.GetStageStats( stage );
+        mInstrumentation.AddStage( SpaceWirePipeline::GetStageName( stage ), stats.items, stats.busySeconds );
+    }
+}
+
+void SpaceWireFrameBuilder::Finish()
+{
+    // flush whatever is left at the end of the data
+    FlushRun();
+    CommitFrames();
+}
+
+void SpaceWireFrameBuilder::ProcessCharacters( const DecodedCharacterStruct* characters, size_t count )
+{
+    mInstrumentation.StartTimer( SpaceWireInstrumentation::kTimerFrameEmit );
+    if( mTrace != NULL )
+    {
+        mTrace->Append( characters, count );
+    }
+    for( const DecodedCharacterStruct* it = characters; it != characters + count; ++it )
+    {
+        if( mHasReverse )
+        {
+            ProcessReverseCharacters( it->startingSample );
+        }
+
+        switch( it->type )
+        {
+        case DecodedCharacterStruct::kControl:
+            // the control counters are in control code order
+            mInstrumentation.Count( ( SpaceWireInstrumentation::CounterEnum )( SpaceWireInstrumentation::kCounterFct + it->value ) );
+            ProcessCharacter( true, it->value, it->startingSample, it->endingSample );
+            break;
+        case DecodedCharacterStruct::kData:
+            mInstrumentation.Count( SpaceWireInstrumentation::kCounterData );
+            ProcessCharacter( false, it->value, it->startingSample, it->endingSample );
+            break;
+        case DecodedCharacterStruct::kParityError:
+            mInstrumentation.Count( SpaceWireInstrumentation::kCounterParityErrors );
+            mStatistics.AddParityError();
+            if( mSettings->mShowErrors )
+            {
+                AddFrame( 0, 0, SpaceWireAnalyzer::kTypeParityError, SpaceWireAnalyzer::kFlagError, it->startingSample, it->endingSample );
+            }
+            break;
+        case DecodedCharacterStruct::kDesync:
+            mInstrumentation.Count( SpaceWireInstrumentation::kCounterDesyncs );
+            mStatistics.AddDesync( it->value == DecodedCharacterStruct::kDesyncDisconnect );
+            // after a disconnect the link starts up again with no credit, as after a loss of sync
+            mCredit.Desync( SpaceWireCreditTracker::kDirectionForward );
+            Desync();
+            break;
+        }
+    }
+    mInstrumentation.StopTimer( SpaceWireInstrumentation::kTimerFrameEmit );
+}
+
+void SpaceWireFrameBuilder::ProcessReverseCharacters( U64 untilSample )
+{
+    const DecodedCharacterStruct* character;
+    while( ( character = ( mReplaying ) ? mReverseTraceReader.Peek() : mReverse->Peek() ) != NULL &&
+           character->startingSample < untilSample )
+    {
+        switch( character->type )
+        {
+        case DecodedCharacterStruct::kControl:
+        case DecodedCharacterStruct::kData:
+            TrackCredit( SpaceWireCreditTracker::kDirectionReverse, character->type == DecodedCharacterStruct::kControl,
+                         character->value, character->startingSample, character->endingSample );
+            CollectReversePacket( character->type == DecodedCharacterStruct::kControl, character->value, character->startingSample,
+                                  character->endingSample );
+            break;
+        case DecodedCharacterStruct::kDesync:
+            mCredit.Desync( SpaceWireCreditTracker::kDirectionReverse );
+            mReversePacket.clear();
+            mReverseEscPrefix = false;
+            break;
+        default:
+            break;
+        }
+        if( mReplaying )
+        {
+            mReverseTraceReader.Pop();
+        }
+        else
+        {
+            if( mReverseTrace != NULL )
+            {
+                mReverseTrace->Append( character, 1 );
+            }
+            mReverse->Pop();
+        }
+    }
+}
+
+void SpaceWireFrameBuilder::TrackCredit( SpaceWireCreditTracker::DirectionEnum direction, bool controlChar, U8 value,
+                                         U64 startingSample, U64 endingSample )
+{
+    mCreditSample = endingSample;
+    SpaceWireCreditTracker::DirectionEnum affected;
+    SpaceWireCreditTracker::EventEnum event = mCredit.AddCharacter( direction, controlChar, value, startingSample, affected );
+    if( event != SpaceWireCreditTracker::kEventNone )
+    {
+        mStatistics.AddCreditError( affected, event == SpaceWireCreditTracker::kEventOverflow );
+        if( mSettings->mShowErrors )
+        {
+            AddFrame( event, affected, SpaceWireAnalyzer::kTypeCreditError, SpaceWireAnalyzer::kFlagError, startingSample, endingSample );
+        }
+    }
+}
+
+void SpaceWireFrameBuilder::ProcessCharacter( bool controlChar, U8 value, U64 startingSample, U64 endingSample )
+{
+    // NULLs and FCTs are idle fill, anything else ends a run of them
+    if( mRunCount != 0 && ( !controlChar || value == SpaceWireAnalyzer::kControlEop || value == SpaceWireAnalyzer::kControlEep ) )
+    {
+        FlushRun();
+    }
+
+    mStatistics.AddCharacter( controlChar, value );
+    if( mHasReverse )
+    {
+        TrackCredit( SpaceWireCreditTracker::kDirectionForward, controlChar, value, startingSample, endingSample );
+    }
+
+    // track the bit rate (control characters are 4 bits, data characters 10)
+    if( mSettings->mShowLinkSpeedChanges && mLinkRate.AddCharacter( startingSample, endingSample, ( controlChar ) ? 4 : 10 ) )
+    {
+        AddFrame( mLinkRate.GetRateBps(), mLinkRate.GetPreviousRateBps(), SpaceWireAnalyzer::kTypeLinkSpeedChange, 0, startingSample,
+                  startingSample + mLinkRate.GetBitSamples() - 1 );
+    }
+
+    // if we're not combining chars, just send it out
+    if( !mSettings->mCombineChars )
+    {
+        // group the character frames of each packet into an sdk packet
+        // (data after ESC is a timecode, and ESC followed by EOP/EEP is an escape error)
+        bool escaped = mEscPrefix;
+        mEscPrefix = controlChar && value == SpaceWireAnalyzer::kControlEsc;
+        if( !controlChar && !escaped )
+        {
+            if( mPacketArena->GetOpenLength() == 0 )
+            {
+                // frames since the last packet are not part of this one
+                mSink.CancelPacket();
+                mPacketDataStartingSample = startingSample;
+            }
+            mPacketArena->Append( value );
+        }
+
+        AddFrame( value, 0, ( controlChar ) ? SpaceWireAnalyzer::kTypeControlCharacter : SpaceWireAnalyzer::kTypeDataCharacter, 0,
+                  startingSample, endingSample );
+
+        if( controlChar && !escaped && ( value == SpaceWireAnalyzer::kControlEop || value == SpaceWireAnalyzer::kControlEep ) &&
+            mPacketArena->GetOpenLength() != 0 )
+        {
+            U64 length = mPacketArena->GetOpenLength();
+            RmapPacketStruct rmap;
+            bool isRmap = value == SpaceWireAnalyzer::kControlEop &&
+                          DecodeRmap( mPacketArena->GetOpenPacket(), mPacketArena->GetStoredLength( length ), length, rmap );
+            U64 handle = mPacketArena->FinishPacket();
+            U64 packetId = mSink.CommitPacket( handle, length, value );
+            if( isRmap )
+            {
+                MatchRmap( rmap, packetId, mPacketDataStartingSample, endingSample );
+            }
+        }
+    }
+    else
+    {
+        // handle continuing ESC sequences
+        if( mEscPrefix )
+        {
+            mEscPrefix = false;
+            if( controlChar && value == SpaceWireAnalyzer::kControlFct )
+            {
+                // ESC + FCT = NULL
+                if( mSettings->mShowNulls )
+                {
+                    AddRun( SpaceWireAnalyzer::kTypeNull, mEscPrefixStartingSample, endingSample );
+                }
+            }
+            else if( !controlChar )
+            {
+                // ESC + DATA = TIMECODE
+                // see if this matches the expected value
+                U8 expectedValue = ( mLastTimecode + 1 ) % 64;
+                bool matchesExpected = (mLastTimecode == 255 || value == expectedValue);
+                S64 jitter;
+                bool hasJitter = mTimecodeStatistics.AddTimecode( value, mEscPrefixStartingSample, jitter );
+                // save results
+                if( mSettings->mShowTimecodes || !matchesExpected && mSettings->mShowErrors )
+                {
+                    // TIMECODE
+                    if( mSettings->mShowTimecodes )
+                    {
+                        U64 delta = 0;
+                        if( mLastTimecode != 255 )
+                        {
+                            delta = mEscPrefixStartingSample - mLastTimecodeStartingSample;
+                        }
+                        U64 data = value;
+                        U8 flags = (matchesExpected) ? 0 : SpaceWireAnalyzer::kFlagWarning;
+                        if( hasJitter && mSettings->mShowTimecodeJitter )
+                        {
+                            data |= ( U64 )jitter << 8;
+                            flags |= SpaceWireAnalyzer::kFlagJitter;
+                        }
+                        AddFrame( data, delta, SpaceWireAnalyzer::kTypeTimecode, flags, mEscPrefixStartingSample, endingSample );
+                    }
+                }
+                // save timecode for later comparison
+                mLastTimecode = value;
+                mLastTimecodeStartingSample = mEscPrefixStartingSample;
+            }
+            else
+            {
+                // anything else is invalid
+                if( mSettings->mShowErrors )
+                {
+                    AddFrame( value, 0, SpaceWireAnalyzer::kTypeEscapeError, SpaceWireAnalyzer::kFlagError, mEscPrefixStartingSample,
+                              endingSample );
+                }
+            }
+        }
+        else
+        {
+            if( controlChar )
+            {
+                if( value == SpaceWireAnalyzer::kControlEsc )
+                {
+                    mEscPrefix = true;
+                    mEscPrefixStartingSample = startingSample;
+                }
+                else if( value == SpaceWireAnalyzer::kControlEop )
+                {
+                    // end of frame
+                    if( mPacketArena->GetOpenLength() == 0 )
+                    {
+                        // empty packet error
+                        if( mSettings->mShowErrors )
+                        {
+                            AddFrame( 0, 0, SpaceWireAnalyzer::kTypeEmptyPacket, 0, startingSample, endingSample );
+                        }
+                    }
+                    else
+                    {
+                        // packet
+                        RmapPacketStruct rmap;
+                        U64 length = mPacketArena->GetOpenLength();
+                        bool isRmap = DecodeRmap( mPacketArena->GetOpenPacket(), mPacketArena->GetStoredLength( length ), length, rmap );
+                        U64 packetId = INVALID_RESULT_INDEX;
+                        if( mSettings->mShowRegularPackets )
+                        {
+                            U8 flags = 0;
+                            if( isRmap )
+                            {
+                                flags = SpaceWireAnalyzer::kFlagRmap;
+                                if( rmap.error != RmapPacketStruct::kErrorNone )
+                                {
+                                    flags |= SpaceWireAnalyzer::kFlagWarning;
+                                }
+                            }
+                            packetId =
+                                AddPacketFrame( SpaceWireAnalyzer::kTypePacket, flags, SpaceWireAnalyzer::kControlEop, endingSample );
+                        }
+                        if( isRmap )
+                        {
+                            MatchRmap( rmap, packetId, mPacketDataStartingSample, endingSample );
+                        }
+                    }
+                    mPacketArena->DiscardPacket();
+                }
+                else if( value == SpaceWireAnalyzer::kControlEep )
+                {
+                    // error packet
+                    if( mPacketArena->GetOpenLength() == 0 )
+                    {
+                        mPacketDataStartingSample = startingSample;
+                    }
+                    if( mSettings->mShowErrorPackets )
+                    {
+                        AddPacketFrame( SpaceWireAnalyzer::kTypeErrorPacket, 0, SpaceWireAnalyzer::kControlEep, endingSample );
+                    }
+                    mPacketArena->DiscardPacket();
+                }
+                else if( value == SpaceWireAnalyzer::kControlFct )
+                {
+                    // FCT (credit)
+                    if( mSettings->mShowFcts )
+                    {
+                        AddRun( SpaceWireAnalyzer::kTypeControlCharacter, startingSample, endingSample );
+                    }
+                }
+            }
+            else
+            {
+                // save data
+                if( mPacketArena->GetOpenLength() == 0 )
+                {
+                    mPacketDataStartingSample = startingSample;
+                }
+                mPacketArena->Append( value );
+            }
+        }
+    }
+}
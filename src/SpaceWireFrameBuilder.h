@@ -0,0 +1,216 @@
+#pragma once
+
+#include <vector>
+
+#include <AnalyzerResults.h>
+
+#include "SpaceWireBitStream.h"
+#include "SpaceWireCharacterDecoder.h"
+#include "SpaceWireCharacterStream.h"
+#include "SpaceWireCharacterTrace.h"
+#include "SpaceWireCreditTracker.h"
+#include "SpaceWireInstrumentation.h"
+#include "SpaceWireLinkRateTracker.h"
+#include "SpaceWireLinkStatistics.h"
+#include "SpaceWirePacketArena.h"
+#include "SpaceWirePipeline.h"
+#include "SpaceWireRmap.h"
+#include "SpaceWireSegmentDecoder.h"
+#include "SpaceWireTimecodeStatistics.h"
+
+class SpaceWireAnalyzerSettings;
+
+// receiver of the frames, packets and RMAP transactions of a decode
+//
+// the analyzer passes them on to its results, the benchmark only counts them
+class SpaceWireFrameSink
+{
+  public:
+    virtual ~SpaceWireFrameSink();
+
+    // add a frame
+    virtual void AddFrame( const Frame& frame ) = 0;
+    // commit the frames added so far, with the statistics up to them
+    virtual void CommitFrames( const LinkStatisticsStruct& statistics, const TimecodeStatisticsStruct& timecodeStatistics ) = 0;
+    // leave the frames added since the last packet out of the next one
+    virtual void CancelPacket() = 0;
+    // group the frames added since the last packet into a packet with the given payload, and
+    // return its id
+    virtual U64 CommitPacket( U64 handle, U64 length, U8 endMarker ) = 0;
+    // add an RMAP transaction and return its id
+    virtual U64 AddRmapTransaction( const RmapTransactionStruct& transaction ) = 0;
+    // return or replace an RMAP transaction
+    virtual RmapTransactionStruct GetRmapTransaction( U64 transactionId ) = 0;
+    virtual void SetRmapTransaction( U64 transactionId, const RmapTransactionStruct& transaction ) = 0;
+    // add a packet to an RMAP transaction
+    virtual void AddPacketToTransaction( U64 transactionId, U64 packetId ) = 0;
+    // report that the decode has got to sample
+    virtual void ReportDecodeProgress( U64 sample ) = 0;
+};
+
+// turns the bits of a capture into characters and the characters into frames
+//
+// holds the decode loops of every decode mode and everything from characters to frames, so the
+// analyzer and the benchmark run the same code.  it is used on a single thread, the threads the
+// decode loops start only ever decode bits into characters.
+class SpaceWireFrameBuilder
+{
+  public:
+    SpaceWireFrameBuilder( SpaceWireFrameSink& sink, SpaceWireInstrumentation& instrumentation );
+
+    // start a decode of the data from firstSample on, keeping packet payloads in packetArena
+    // reverse holds the characters of the reverse direction, or is NULL if there is none
+    void Reset( const SpaceWireAnalyzerSettings* settings, U32 sampleRateHz, U64 firstSample, SpaceWirePacketArena* packetArena,
+                SpaceWireCharacterStream* reverse );
+
+    // record the characters decoded in each direction from now on (NULL to stop recording)
+    void SetRecording( SpaceWireCharacterTrace* trace, SpaceWireCharacterTrace* reverseTrace );
+
+    // decode the whole bit stream serially on this thread
+    void DecodeStream( SpaceWireBitStream& bitStream );
+
+    // decode the bit stream in segments on a pool of worker threads
+    void DecodeSegments( SpaceWireBitStream& bitStream );
+
+    // decode the bit stream with character decoding on its own thread
+    void DecodePipelined( SpaceWireBitStream& bitStream );
+
+    // rebuild the frames from the characters recorded by an earlier decode
+    void DecodeTrace( const SpaceWireCharacterTrace& trace, const SpaceWireCharacterTrace& reverseTrace );
+
+    // add the frame of the waiting run and commit all frames, at the end of the data
+    void Finish();
+
+  protected:
+    // number of recovered bits handled per block
+    static const U32 kBitBlockSize = 4096;
+
+    // commit once this many frames are pending
+    static const U32 kCommitFrameCount = 4096;
+    // commit once pending frames span this many seconds of capture
+    static constexpr double kCommitSpanSeconds = 0.05;
+
+    // desync the stream
+    void Desync();
+
+    // collect the oldest segment from mSegmentDecoder and process its characters
+    void CollectSegment();
+
+    // handle each decoded character
+    void ProcessCharacters( const DecodedCharacterStruct* characters, size_t count );
+
+    // handle the characters of the reverse direction which start before untilSample
+    void ProcessReverseCharacters( U64 untilSample );
+
+    // update flow control credit for a character and report credit errors
+    void TrackCredit( SpaceWireCreditTracker::DirectionEnum direction, bool controlChar, U8 value, U64 startingSample,
+                      U64 endingSample );
+
+    // handle a single decoded character
+    void ProcessCharacter( bool controlChar, U8 value, U64 startingSample, U64 endingSample );
+
+    // add a new frame
+    void AddFrame( U64 mData1, U64 mData2, U8 mType, U8 mFlags, U64 mStartingSampleInclusive, U64 mEndingSampleInclusive );
+
+    // add a NULL (kTypeNull) or FCT (kTypeControlCharacter) frame, or extend the run of them
+    // waiting to be added as one frame
+    void AddRun( U8 type, U64 startingSample, U64 endingSample );
+
+    // add the frame of the waiting run, if any
+    void FlushRun();
+
+    // add a packet or error packet frame for the open packet in mPacketArena as its own packet
+    // and return the packet id
+    U64 AddPacketFrame( U8 type, U8 flags, U8 endMarker, U64 endingSample );
+
+    // decode a packet ended by EOP as RMAP if enabled, returns false if it is not RMAP
+    bool DecodeRmap( const U8* data, U64 storedLength, U64 length, RmapPacketStruct& packet );
+
+    // start a transaction for an RMAP command, or complete one with its reply
+    // packetId is the packet of the RMAP packet, or INVALID_RESULT_INDEX if it has none
+    void MatchRmap( const RmapPacketStruct& packet, U64 packetId, U64 startingSample, U64 endingSample );
+
+    // collect the packets of the reverse direction for RMAP reply matching
+    void CollectReversePacket( bool controlChar, U8 value, U64 startingSample, U64 endingSample );
+
+    // commit all frames added since the last commit
+    void CommitFrames();
+
+    // commit if the pending frames span kCommitSpanSeconds by sample
+    void CommitIfDue( U64 sample );
+
+    SpaceWireFrameSink& mSink;
+    // hot path counters and timers (only kept in instrumented builds)
+    SpaceWireInstrumentation& mInstrumentation;
+    // frames added, for the throughput of the frame emission stage
+    SpaceWireCounter mFramesAdded;
+    const SpaceWireAnalyzerSettings* mSettings;
+
+    // number of frames added but not yet committed
+    U32 mUncommittedFrames;
+    // frames ending at or after this sample trigger a commit
+    U64 mNextCommitSample;
+    // number of samples spanned by kCommitSpanSeconds
+    U64 mCommitSampleSpan;
+
+    // block of bits read from the bit stream
+    RecoveredBitStruct mBitBlock[ kBitBlockSize ];
+    // character decoder for serial decoding
+    SpaceWireCharacterDecoder mDecoder;
+    // segment decoder for parallel decoding
+    SpaceWireSegmentDecoder mSegmentDecoder;
+    // character decoding thread for pipelined decoding
+    SpaceWirePipeline mPipeline;
+    // characters waiting to be processed
+    std::vector<DecodedCharacterStruct> mCharacters;
+
+    // traces the characters are recorded in, or NULL
+    SpaceWireCharacterTrace* mTrace;
+    SpaceWireCharacterTrace* mReverseTrace;
+    // reads the reverse trace while the frames are rebuilt
+    SpaceWireCharacterTrace::Reader mReverseTraceReader;
+    // true while the frames are rebuilt from a trace
+    bool mReplaying;
+
+    // link bit rate estimate
+    SpaceWireLinkRateTracker mLinkRate;
+    // running link statistics
+    SpaceWireLinkStatistics mStatistics;
+    // timecode period and jitter statistics
+    SpaceWireTimecodeStatistics mTimecodeStatistics;
+    // true if the reverse direction of the link is decoded as well
+    bool mHasReverse;
+    // characters of the reverse direction
+    SpaceWireCharacterStream* mReverse;
+    // flow control credit in both directions
+    SpaceWireCreditTracker mCredit;
+    // last sample passed to mCredit
+    U64 mCreditSample;
+    // packet of the reverse direction being received, for RMAP decoding
+    std::vector<U8> mReversePacket;
+    U64 mReversePacketStartingSample;
+    bool mReverseEscPrefix;
+    // RMAP commands waiting for their reply
+    SpaceWireRmapMatcher mRmapMatcher;
+
+    // packet payload store (holds the current packet while it is received)
+    SpaceWirePacketArena* mPacketArena;
+    // first sample of first bit of data buffer
+    U64 mPacketDataStartingSample;
+
+    // run of NULLs or FCTs not yet added (mRunCount is 0 if there is none)
+    U8 mRunType;
+    U64 mRunCount;
+    U64 mRunStartingSample;
+    U64 mRunEndingSample;
+
+    // true if ESC code was immediately previous
+    bool mEscPrefix;
+    // first sample of previous ESC code
+    U64 mEscPrefixStartingSample;
+
+    // last timecode received, or 255 if none
+    U8 mLastTimecode;
+    // first bit of last timecode received
+    U64 mLastTimecodeStartingSample;
+};
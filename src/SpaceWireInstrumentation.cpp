@@ -0,0 +1,131 @@
+#include "SpaceWireInstrumentation.h"
+
+#ifdef SPACEWIRE_INSTRUMENTATION
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "SpaceWireExportWriter.h"
+
+namespace
+{
+    const char* const kCounterNames[ SpaceWireInstrumentation::kCounterCount ] = {
+        "edges", "sdk_calls", "bits", "fct", "eop", "eep", "esc", "data", "parity_errors", "desyncs", "frames", "commits",
+    };
+
+    const char* const kTimerNames[ SpaceWireInstrumentation::kTimerCount ] = {
+        "edge_fetch_seconds",
+        "decode_seconds",
+        "frame_emit_seconds",
+    };
+
+    std::string GetOutputPath()
+    {
+        const char* path = getenv( "SPACEWIRE_INSTRUMENTATION_FILE" );
+        if( path != NULL && path[ 0 ] != '\0' )
+        {
+            return path;
+        }
+        const char* directory = getenv( "TMPDIR" );
+        if( directory == NULL )
+        {
+            directory = getenv( "TEMP" );
+        }
+        if( directory == NULL )
+        {
+            directory = "/tmp";
+        }
+        return std::string( directory ) + "/spacewire_instrumentation.json";
+    }
+
+    void WriteNumber( SpaceWireExportWriter& writer, const char* name, U64 value, bool last = false )
+    {
+        writer.Write( "    \"" );
+        writer.Write( name );
+        writer.Write( "\": " );
+        writer.WriteUnsigned( value );
+        writer.Write( ( last ) ? "\n" : ",\n" );
+    }
+}
+
+SpaceWireInstrumentation::SpaceWireInstrumentation()
+{
+    Reset();
+}
+
+void SpaceWireInstrumentation::Reset()
+{
+    for( U32 i = 0; i < kCounterCount; ++i )
+    {
+        mCounters[ i ] = 0;
+    }
+    for( U32 i = 0; i < kTimerCount; ++i )
+    {
+        mSeconds[ i ] = 0.0;
+    }
+    mStageCount = 0;
+}
+
+void SpaceWireInstrumentation::AddStage( const char* name, U64 items, double busySeconds )
+{
+    if( mStageCount < kMaxStageCount )
+    {
+        StageStruct& stage = mStages[ mStageCount++ ];
+        stage.name = name;
+        stage.items = items;
+        stage.busySeconds = busySeconds;
+    }
+}
+
+bool SpaceWireInstrumentation::Write( const char* decodeMode ) const
+{
+    SpaceWireExportWriter writer;
+    if( !writer.Open( GetOutputPath().c_str() ) )
+    {
+        return false;
+    }
+
+    writer.Write( "{\n  \"decode_mode\": \"" );
+    writer.Write( decodeMode );
+    writer.Write( "\",\n  \"counters\": {\n" );
+    for( U32 i = 0; i < kCounterCount; ++i )
+    {
+        WriteNumber( writer, kCounterNames[ i ], mCounters[ i ] );
+    }
+    // bits in no character were skipped while hunting for sync or lost to errors
+    U64 characterBits = 4 * ( mCounters[ kCounterFct ] + mCounters[ kCounterEop ] + mCounters[ kCounterEep ] + mCounters[ kCounterEsc ] ) +
+                        10 * mCounters[ kCounterData ];
+    U64 discarded = ( mCounters[ kCounterBits ] > characterBits ) ? mCounters[ kCounterBits ] - characterBits : 0;
+    WriteNumber( writer, "discarded_bits", discarded, true );
+
+    writer.Write( "  },\n  \"timers\": {\n" );
+    for( U32 i = 0; i < kTimerCount; ++i )
+    {
+        char text[ 64 ];
+        snprintf( text, sizeof( text ), "    \"%s\": %.6f%s\n", kTimerNames[ i ], mSeconds[ i ], ( i + 1 < kTimerCount ) ? "," : "" );
+        writer.Write( text );
+    }
+    writer.Write( "  }" );
+
+    // the throughput of each stage of a pipelined decode
+    if( mStageCount != 0 )
+    {
+        writer.Write( ",\n  \"stages\": {\n" );
+        for( U32 i = 0; i < mStageCount; ++i )
+        {
+            const StageStruct& stage = mStages[ i ];
+            double rate = ( stage.busySeconds > 0.0 ) ? stage.items / stage.busySeconds : 0.0;
+            char text[ 160 ];
+            snprintf( text, sizeof( text ), "    \"%s\": { \"items\": %llu, \"busy_seconds\": %.6f, \"items_per_second\": %.0f }%s\n",
+                      stage.name, ( unsigned long long )stage.items, stage.busySeconds, rate, ( i + 1 < mStageCount ) ? "," : "" );
+            writer.Write( text );
+        }
+        writer.Write( "  }" );
+    }
+    writer.Write( "\n}\n" );
+    writer.Close();
+    return true;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <chrono>
+
+#include <LogicPublicTypes.h>
+
+// hot path counters and timers, compiled in by defining SPACEWIRE_INSTRUMENTATION
+//
+// without it every counter and timer below is an empty inline function, so the instrumented code
+// costs nothing.  with it the analyzer writes the totals of each decode as JSON to the file named
+// by the SPACEWIRE_INSTRUMENTATION_FILE environment variable, or to
+// spacewire_instrumentation.json in the temp directory.
+
+// a counter owned by one thread, which only counts in instrumented builds
+class SpaceWireCounter
+{
+  public:
+#ifdef SPACEWIRE_INSTRUMENTATION
+    SpaceWireCounter() : mValue( 0 )
+    {
+    }
+    void Reset()
+    {
+        mValue = 0;
+    }
+    void Add( U64 count )
+    {
+        mValue += count;
+    }
+    U64 Get() const
+    {
+        return mValue;
+    }
+
+  protected:
+    U64 mValue;
+#else
+    void Reset()
+    {
+    }
+    void Add( U64 )
+    {
+    }
+    U64 Get() const
+    {
+        return 0;
+    }
+#endif
+};
+
+// counters and phase timers of one decode
+class SpaceWireInstrumentation
+{
+  public:
+    enum CounterEnum
+    {
+        // edges read from the channels of both directions, and calls made into the SDK
+        kCounterEdges,
+        kCounterSdkCalls,
+        // bits recovered from the forward direction
+        kCounterBits,
+        // decoded characters by type
+        kCounterFct,
+        kCounterEop,
+        kCounterEep,
+        kCounterEsc,
+        kCounterData,
+        kCounterParityErrors,
+        kCounterDesyncs,
+        // AddFrame and CommitResults calls
+        kCounterFrames,
+        kCounterCommits,
+        kCounterCount,
+    };
+
+    enum TimerEnum
+    {
+        // reading edges and recovering bits
+        kTimerEdgeFetch,
+        // decoding bits into characters
+        kTimerDecode,
+        // turning characters into frames
+        kTimerFrameEmit,
+        kTimerCount,
+    };
+
+#ifdef SPACEWIRE_INSTRUMENTATION
+    SpaceWireInstrumentation();
+
+    // clear all counters and timers
+    void Reset();
+
+    void Count( CounterEnum counter, U64 count = 1 )
+    {
+        mCounters[ counter ] += count;
+    }
+    // time a phase (phases may nest, but a timer may not be started twice)
+    void StartTimer( TimerEnum timer )
+    {
+        mStarted[ timer ] = Clock::now();
+    }
+    void StopTimer( TimerEnum timer )
+    {
+        mSeconds[ timer ] += std::chrono::duration<double>( Clock::now() - mStarted[ timer ] ).count();
+    }
+    // add time measured elsewhere (by the pipeline decode thread)
+    void AddSeconds( TimerEnum timer, double seconds )
+    {
+        mSeconds[ timer ] += seconds;
+    }
+    // add the throughput counter of a pipeline stage (the name must outlive the instrumentation)
+    void AddStage( const char* name, U64 items, double busySeconds );
+
+    // write the totals as JSON, returns false if the file can't be written
+    bool Write( const char* decodeMode ) const;
+
+  protected:
+    typedef std::chrono::steady_clock Clock;
+
+    struct StageStruct
+    {
+        const char* name;
+        U64 items;
+        double busySeconds;
+    };
+    static const U32 kMaxStageCount = 4;
+
+    U64 mCounters[ kCounterCount ];
+    double mSeconds[ kTimerCount ];
+    Clock::time_point mStarted[ kTimerCount ];
+    StageStruct mStages[ kMaxStageCount ];
+    U32 mStageCount;
+#else
+    void Reset()
+    {
+    }
+    void Count( CounterEnum, U64 = 1 )
+    {
+    }
+    void StartTimer( TimerEnum )
+    {
+    }
+    void StopTimer( TimerEnum )
+    {
+    }
+    void AddSeconds( TimerEnum, double )
+    {
+    }
+    void AddStage( const char*, U64, double )
+    {
+    }
+    bool Write( const char* ) const
+    {
+        return true;
+    }
+#endif
+};
@@ -0,0 +1,83 @@
+#include "SpaceWireLinkRateTracker.h"
+
+SpaceWireLinkRateTracker::SpaceWireLinkRateTracker()
+{
+    Reset( 1 );
+}
+
+void SpaceWireLinkRateTracker::Reset( U32 sampleRateHz )
+{
+    mSampleRateHz = sampleRateHz;
+    mReportedPeriod = 0;
+    mReportedRateBps = 0;
+    mPreviousRateBps = 0;
+    Restart();
+}
+
+void SpaceWireLinkRateTracker::Restart()
+{
+    mWindowHead = 0;
+    mWindowCount = 0;
+    mSumSamples = 0;
+    mSumBits = 0;
+    mOutOfBandCount = 0;
+}
+
+bool SpaceWireLinkRateTracker::AddCharacter( U64 startingSample, U64 endingSample, U32 bits )
+{
+    U32 samples = ( U32 )( endingSample + 1 - startingSample );
+
+    // slide the window
+    if( mWindowCount == kWindowCharacters )
+    {
+        mSumSamples -= mWindowSamples[ mWindowHead ];
+        mSumBits -= mWindowBits[ mWindowHead ];
+    }
+    else
+    {
+        ++mWindowCount;
+    }
+    mWindowSamples[ mWindowHead ] = samples;
+    mWindowBits[ mWindowHead ] = ( U8 )bits;
+    mWindowHead = ( mWindowHead + 1 ) % kWindowCharacters;
+    mSumSamples += samples;
+    mSumBits += bits;
+
+    if( mWindowCount < kWindowCharacters )
+    {
+        return false;
+    }
+
+    U64 period = ( mSumSamples << kFractionBits ) / mSumBits;
+    if( mReportedPeriod == 0 )
+    {
+        // first estimate, nothing to compare with
+        mReportedPeriod = period;
+        mReportedRateBps = ( U64 )mSampleRateHz * mSumBits / mSumSamples;
+        return false;
+    }
+
+    U64 difference = ( period > mReportedPeriod ) ? period - mReportedPeriod : mReportedPeriod - period;
+    if( difference * kBandDivisor <= mReportedPeriod )
+    {
+        mOutOfBandCount = 0;
+        return false;
+    }
+
+    // wait until the window holds only characters received after the estimate left the band
+    if( ++mOutOfBandCount < kWindowCharacters )
+    {
+        return false;
+    }
+    mOutOfBandCount = 0;
+    mReportedPeriod = period;
+    mPreviousRateBps = mReportedRateBps;
+    mReportedRateBps = ( U64 )mSampleRateHz * mSumBits / mSumSamples;
+    return true;
+}
+
+U64 SpaceWireLinkRateTracker::GetBitSamples() const
+{
+    U64 samples = mReportedPeriod >> kFractionBits;
+    return ( samples != 0 ) ? samples : 1;
+}
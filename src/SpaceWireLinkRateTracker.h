@@ -0,0 +1,63 @@
+#pragma once
+
+#include <LogicPublicTypes.h>
+
+// estimates the link bit rate from consecutive characters and detects rate changes
+//
+// the rate is the number of bits over the number of samples of the last kWindowCharacters
+// characters, kept as running sums so each character costs O(1) integer operations.  a change is
+// reported once the estimate has left the band around the last reported rate and every character
+// in the window was received after it left, so a transition is reported once, at the new rate.
+class SpaceWireLinkRateTracker
+{
+  public:
+    // number of characters in the sliding window
+    static const U32 kWindowCharacters = 16;
+    // a rate outside 1 +/- 1/kBandDivisor of the reported rate is a change
+    static const U32 kBandDivisor = 8;
+
+    SpaceWireLinkRateTracker();
+
+    // forget everything, including the reported rate
+    void Reset( U32 sampleRateHz );
+    // forget the window (after a desync), keeping the reported rate
+    void Restart();
+
+    // add a character of the given number of bits
+    // returns true if it confirmed a change from the reported rate
+    bool AddCharacter( U64 startingSample, U64 endingSample, U32 bits );
+
+    // return the reported rate in bits per second (0 before the first estimate)
+    U64 GetRateBps() const
+    {
+        return mReportedRateBps;
+    }
+    // return the rate reported before the last change
+    U64 GetPreviousRateBps() const
+    {
+        return mPreviousRateBps;
+    }
+    // return the length of one bit at the current estimate, in samples (at least 1)
+    U64 GetBitSamples() const;
+
+  protected:
+    // number of fractional bits in bit periods
+    static const U32 kFractionBits = 8;
+
+    U32 mSampleRateHz;
+
+    // samples and bits of the characters in the window
+    U32 mWindowSamples[ kWindowCharacters ];
+    U8 mWindowBits[ kWindowCharacters ];
+    U32 mWindowHead;
+    U32 mWindowCount;
+    U64 mSumSamples;
+    U32 mSumBits;
+
+    // bit period of the reported rate in samples (fixed point), or 0 if none
+    U64 mReportedPeriod;
+    U64 mReportedRateBps;
+    U64 mPreviousRateBps;
+    // number of consecutive characters with the estimate outside the band
+    U32 mOutOfBandCount;
+};
@@ -0,0 +1,190 @@
+#include <cstring>
+
+#include "SpaceWireLinkStatistics.h"
+#include "SpaceWireAnalyzer.h"
+#include "SpaceWireExportWriter.h"
+
+SpaceWireLinkStatistics::SpaceWireLinkStatistics()
+{
+    Reset();
+}
+
+void SpaceWireLinkStatistics::Reset()
+{
+    memset( &mStatistics, 0, sizeof( mStatistics ) );
+    mEscPrefix = false;
+    mPacketLength = 0;
+}
+
+void SpaceWireLinkStatistics::AddCharacter( bool controlChar, U8 value )
+{
+    if( controlChar )
+    {
+        ++mStatistics.controlCharacters[ value & 0b11 ];
+    }
+    else
+    {
+        ++mStatistics.dataCharacters;
+    }
+
+    if( mEscPrefix )
+    {
+        // ESC + FCT = NULL, ESC + data = timecode, anything else is an error
+        mEscPrefix = false;
+        if( !controlChar )
+        {
+            ++mStatistics.timecodes;
+        }
+        else if( value == SpaceWireAnalyzer::kControlFct )
+        {
+            ++mStatistics.nulls;
+        }
+        else
+        {
+            ++mStatistics.escapeErrors;
+        }
+        return;
+    }
+
+    if( !controlChar )
+    {
+        ++mPacketLength;
+        return;
+    }
+
+    switch( value )
+    {
+    case SpaceWireAnalyzer::kControlEsc:
+        mEscPrefix = true;
+        break;
+    case SpaceWireAnalyzer::kControlFct:
+        ++mStatistics.fcts;
+        break;
+    case SpaceWireAnalyzer::kControlEop:
+        if( mPacketLength == 0 )
+        {
+            ++mStatistics.emptyPackets;
+            break;
+        }
+        if( mStatistics.packets == 0 || mPacketLength < mStatistics.minPacketLength )
+        {
+            mStatistics.minPacketLength = mPacketLength;
+        }
+        if( mPacketLength > mStatistics.maxPacketLength )
+        {
+            mStatistics.maxPacketLength = mPacketLength;
+        }
+        ++mStatistics.packets;
+        mStatistics.packetBytes += mPacketLength;
+        mPacketLength = 0;
+        break;
+    case SpaceWireAnalyzer::kControlEep:
+        ++mStatistics.errorPackets;
+        mPacketLength = 0;
+        break;
+    }
+}
+
+void SpaceWireLinkStatistics::AddParityError()
+{
+    ++mStatistics.parityErrors;
+}
+
+void SpaceWireLinkStatistics::AddDesync( bool disconnect )
+{
+    if( disconnect )
+    {
+        ++mStatistics.disconnects;
+    }
+    else
+    {
+        ++mStatistics.desyncs;
+    }
+    mEscPrefix = false;
+    mPacketLength = 0;
+}
+
+void SpaceWireLinkStatistics::AddCreditError( U32 direction, bool overflow )
+{
+    if( overflow )
+    {
+        ++mStatistics.creditOverflows[ direction ];
+    }
+    else
+    {
+        ++mStatistics.creditUnderflows[ direction ];
+    }
+}
+
+namespace
+{
+    void WriteLine( SpaceWireExportWriter& writer, const char* name, U64 value )
+    {
+        writer.Write( name );
+        writer.WriteChar( ',' );
+        writer.WriteUnsigned( value );
+        writer.WriteChar( '\n' );
+    }
+
+    // write part / total as a percentage with two decimal places
+    void WritePercentLine( SpaceWireExportWriter& writer, const char* name, U64 part, U64 total )
+    {
+        U64 hundredths = ( total != 0 ) ? part * 10000 / total : 0;
+        writer.Write( name );
+        writer.WriteChar( ',' );
+        writer.WriteUnsigned( hundredths / 100 );
+        writer.WriteChar( '.' );
+        writer.WritePadded( hundredths % 100, 2 );
+        writer.WriteChar( '\n' );
+    }
+}
+
+void SpaceWireLinkStatistics::WriteReport( const LinkStatisticsStruct& statistics, U32 sampleRateHz, SpaceWireExportWriter& writer )
+{
+    U64 controlCharacters = statistics.controlCharacters[ 0 ] + statistics.controlCharacters[ 1 ] +
+                            statistics.controlCharacters[ 2 ] + statistics.controlCharacters[ 3 ];
+
+    // share of the link bits: control characters are 4 bits, data characters 10 and NULLs 8
+    U64 totalBits = 4 * controlCharacters + 10 * statistics.dataCharacters;
+    U64 packetDataBits = 10 * ( statistics.dataCharacters - statistics.timecodes );
+
+    writer.Write( "Statistic,Value\n" );
+    WriteLine( writer, "characters", controlCharacters + statistics.dataCharacters );
+    WriteLine( writer, "control characters", controlCharacters );
+    WriteLine( writer, "FCT characters", statistics.controlCharacters[ SpaceWireAnalyzer::kControlFct ] );
+    WriteLine( writer, "EOP characters", statistics.controlCharacters[ SpaceWireAnalyzer::kControlEop ] );
+    WriteLine( writer, "EEP characters", statistics.controlCharacters[ SpaceWireAnalyzer::kControlEep ] );
+    WriteLine( writer, "ESC characters", statistics.controlCharacters[ SpaceWireAnalyzer::kControlEsc ] );
+    WriteLine( writer, "data characters", statistics.dataCharacters );
+    WriteLine( writer, "NULLs", statistics.nulls );
+    WriteLine( writer, "FCTs", statistics.fcts );
+    WriteLine( writer, "timecodes", statistics.timecodes );
+    WritePercentLine( writer, "NULL bits [%]", 8 * statistics.nulls, totalBits );
+    WritePercentLine( writer, "FCT bits [%]", 4 * statistics.fcts, totalBits );
+    WritePercentLine( writer, "packet data bits [%]", packetDataBits, totalBits );
+    WriteLine( writer, "packets (EOP)", statistics.packets );
+    WriteLine( writer, "error packets (EEP)", statistics.errorPackets );
+    WriteLine( writer, "empty packets", statistics.emptyPackets );
+    WriteLine( writer, "packet bytes", statistics.packetBytes );
+    WriteLine( writer, "min packet length", statistics.minPacketLength );
+    WriteLine( writer, "avg packet length", ( statistics.packets != 0 ) ? statistics.packetBytes / statistics.packets : 0 );
+    WriteLine( writer, "max packet length", statistics.maxPacketLength );
+    WriteLine( writer, "parity errors", statistics.parityErrors );
+    WriteLine( writer, "escape errors", statistics.escapeErrors );
+    WriteLine( writer, "desyncs", statistics.desyncs );
+    WriteLine( writer, "disconnects", statistics.disconnects );
+
+    static const char* direction[ 2 ] = { "", "reverse " };
+    writer.SetTimeBase( 0, sampleRateHz );
+    for( U32 i = 0; i < 2; ++i )
+    {
+        writer.Write( direction[ i ] );
+        WriteLine( writer, "credit underflows", statistics.creditUnderflows[ i ] );
+        writer.Write( direction[ i ] );
+        WriteLine( writer, "credit overflows", statistics.creditOverflows[ i ] );
+        writer.Write( direction[ i ] );
+        writer.Write( "credit stall [s]," );
+        writer.WriteTime( statistics.creditStallSamples[ i ] );
+        writer.WriteChar( '\n' );
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <LogicPublicTypes.h>
+
+class SpaceWireExportWriter;
+
+// counters describing the traffic in a capture
+struct LinkStatisticsStruct
+{
+    // every decoded character, by code (FCT, EOP, EEP, ESC) and data
+    U64 controlCharacters[ 4 ];
+    U64 dataCharacters;
+
+    // characters by meaning
+    U64 nulls;
+    U64 fcts;
+    U64 timecodes;
+
+    // packets ended by EOP, with at least one byte
+    U64 packets;
+    U64 packetBytes;
+    U64 minPacketLength;
+    U64 maxPacketLength;
+    // packets ended by EEP, and EOPs without data
+    U64 errorPackets;
+    U64 emptyPackets;
+
+    // errors
+    U64 parityErrors;
+    U64 escapeErrors;
+    U64 desyncs;
+    // losses of sync because the link went silent (not counted in desyncs)
+    U64 disconnects;
+
+    // flow control credit of each direction (only tracked with the reverse channels set)
+    U64 creditUnderflows[ 2 ];
+    U64 creditOverflows[ 2 ];
+    // samples spent in the middle of a packet without credit
+    U64 creditStallSamples[ 2 ];
+};
+
+// keeps link statistics up to date as characters are decoded
+//
+// the statistics follow the character stream, independent of which frames are shown.
+class SpaceWireLinkStatistics
+{
+  public:
+    SpaceWireLinkStatistics();
+
+    // clear all counters
+    void Reset();
+
+    // count a decoded character
+    void AddCharacter( bool controlChar, U8 value );
+    // count a parity error
+    void AddParityError();
+    // count a loss of synchronization, or a disconnect (either drops any partial packet)
+    void AddDesync( bool disconnect );
+    // count a credit underflow or overflow of a direction
+    void AddCreditError( U32 direction, bool overflow );
+
+    const LinkStatisticsStruct& Get() const
+    {
+        return mStatistics;
+    }
+
+    // write statistics as "statistic,value" csv lines
+    static void WriteReport( const LinkStatisticsStruct& statistics, U32 sampleRateHz, SpaceWireExportWriter& writer );
+
+  protected:
+    LinkStatisticsStruct mStatistics;
+    // true if the previous character was an ESC
+    bool mEscPrefix;
+    // number of data characters in the current packet
+    U64 mPacketLength;
+};
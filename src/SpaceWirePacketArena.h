@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+// length, checksum and byte statistics of a whole packet
+struct PacketDigestStruct
+{
+    U64 length;
+    // CRC-32 (IEEE 802.3) of all bytes
+    U32 crc;
+    U8 minByte;
+    U8 maxByte;
+    // sum of all bytes, for the mean
+    U64 byteSum;
+};
+
+// append-only store for the payload of every decoded packet
+//
+// payloads are kept contiguously in large chunks which are never moved or freed once a packet in
+// them has been finished, so a finished packet can be read in place from any thread while the
+// analyzer keeps appending.  packets are referenced by the handle returned from FinishPacket().
+//
+// in digest mode only the first kHeadBytes and last kTailBytes of a packet are kept, preceded by
+// a PacketDigestStruct computed as the bytes arrive, so the memory per packet is bounded no
+// matter how long the packet is.
+class SpaceWirePacketArena
+{
+  public:
+    // default size of each chunk in bytes
+    static const U32 kChunkSize = 1 << 20;
+
+    // bytes kept from the start and end of each packet in digest mode
+    static const U32 kHeadBytes = 64;
+    static const U32 kTailBytes = 64;
+
+    SpaceWirePacketArena();
+    ~SpaceWirePacketArena();
+
+    // keep only the head, tail and digest of packets (set before the first packet)
+    void SetDigestMode( bool digestMode );
+    bool IsDigestMode() const
+    {
+        return mDigestMode;
+    }
+
+    // append a byte to the open packet
+    void Append( U8 value )
+    {
+        if( mDigestMode )
+        {
+            AppendDigest( value );
+            return;
+        }
+        if( mWrite == mChunkEnd )
+        {
+            Grow();
+        }
+        *mWrite++ = value;
+    }
+
+    // return the stored bytes of the open packet (valid until the next Append)
+    const U8* GetOpenPacket()
+    {
+        return ( mDigestMode ) ? PlaceTail() : mPacketStart;
+    }
+
+    // return the number of bytes in the open packet
+    U64 GetOpenLength() const
+    {
+        return ( mDigestMode ) ? mDigest.length : mWrite - mPacketStart;
+    }
+
+    // return how many bytes of a packet of the given length are stored
+    // (in digest mode the head is followed directly by the tail)
+    U64 GetStoredLength( U64 length ) const
+    {
+        return ( mDigestMode && length > kHeadBytes + kTailBytes ) ? kHeadBytes + kTailBytes : length;
+    }
+
+    // close the open packet and return its handle
+    U64 FinishPacket();
+    // drop the bytes of the open packet
+    void DiscardPacket();
+
+    // return the payload of a finished packet
+    const U8* GetPacket( U64 handle ) const;
+    // return the digest of a finished packet, computing it if the whole payload is stored
+    void GetDigest( U64 handle, U64 length, PacketDigestStruct& digest ) const;
+
+    // compute the digest of a complete payload
+    static void ComputeDigest( const U8* data, U64 length, PacketDigestStruct& digest );
+    // add bytes to a CRC-32
+    static U32 Crc32( const U8* data, U64 length, U32 crc = 0 );
+
+    // return the number of bytes held by all chunks
+    U64 GetCapacity() const;
+
+  protected:
+    // move the open packet to a new chunk with room for more bytes
+    void Grow();
+    // make room for size more bytes of the open packet
+    void Reserve( U64 size )
+    {
+        while( ( U64 )( mChunkEnd - mWrite ) < size )
+        {
+            Grow();
+        }
+    }
+    // append a byte in digest mode
+    void AppendDigest( U8 value );
+    // copy the kept tail of the open packet after its head, and return the first stored byte
+    U8* PlaceTail();
+    // clear the digest of the open packet
+    void ResetDigest();
+
+    // chunks, in order of allocation (guarded by mChunksMutex)
+    std::vector<std::unique_ptr<U8[]>> mChunks;
+    std::vector<U64> mChunkSizes;
+    mutable std::mutex mChunksMutex;
+
+    // first byte of the open packet
+    U8* mPacketStart;
+    // next byte to write
+    U8* mWrite;
+    // end of the current chunk
+    U8* mChunkEnd;
+
+    bool mDigestMode;
+    // digest of the open packet, and the last kTailBytes bytes of it as a ring
+    PacketDigestStruct mDigest;
+    U8 mTail[ kTailBytes ];
+};
@@ -0,0 +1,107 @@
+#include "SpaceWirePipeline.h"
+
+SpaceWirePipeline::SpaceWirePipeline() : mBitRing( 1 << 16 ), mCharacterRing( 1 << 14 )
+{
+    for( U32 i = 0; i < kStageCount; ++i )
+    {
+        mStats[ i ].items = 0;
+        mStats[ i ].busySeconds = 0.0;
+    }
+}
+
+SpaceWirePipeline::~SpaceWirePipeline()
+{
+    Stop();
+}
+
+void SpaceWirePipeline::Start( bool desyncAfterError )
+{
+    Stop();
+    mDecoder.Reset();
+    mDecoder.SetDesyncAfterError( desyncAfterError );
+    mBitRing.Reset();
+    mCharacterRing.Reset();
+    for( U32 i = 0; i < kStageCount; ++i )
+    {
+        mStats[ i ].items = 0;
+        mStats[ i ].busySeconds = 0.0;
+    }
+
+    mDecodeThread = std::thread( &SpaceWirePipeline::DecodeStage, this );
+}
+
+void SpaceWirePipeline::Stop()
+{
+    // release the decode thread if it is blocked on a full or empty ring
+    mBitRing.Abort();
+    mCharacterRing.Abort();
+    if( mDecodeThread.joinable() )
+    {
+        mDecodeThread.join();
+    }
+}
+
+U32 SpaceWirePipeline::WriteBits( const RecoveredBitStruct* bits, U32 count )
+{
+    return mBitRing.TryWrite( bits, count );
+}
+
+void SpaceWirePipeline::WaitForBitSpace()
+{
+    mBitRing.WaitForSpace();
+}
+
+void SpaceWirePipeline::CloseBits()
+{
+    mBitRing.Close();
+}
+
+void SpaceWirePipeline::DecodeStage()
+{
+    RecoveredBitStruct bits[ kBlockSize ];
+    std::vector<DecodedCharacterStruct> characters;
+    characters.reserve( kBlockSize );
+    while( true )
+    {
+        U32 count = mBitRing.Read( bits, kBlockSize );
+        if( count == 0 )
+        {
+            break;
+        }
+        StartStage( kStageDecode );
+        characters.clear();
+        mDecoder.Decode( bits, count, characters );
+        StopStage( kStageDecode, characters.size() );
+        if( !characters.empty() && !mCharacterRing.Write( characters.data(), ( U32 )characters.size() ) )
+        {
+            break;
+        }
+    }
+    mCharacterRing.Close();
+}
+
+U32 SpaceWirePipeline::TryReadCharacters( DecodedCharacterStruct* characters, U32 maxCount )
+{
+    return mCharacterRing.TryRead( characters, maxCount );
+}
+
+U32 SpaceWirePipeline::ReadCharacters( DecodedCharacterStruct* characters, U32 maxCount )
+{
+    U32 count = mCharacterRing.Read( characters, maxCount );
+    if( count == 0 )
+    {
+        Stop();
+    }
+    return count;
+}
+
+const SpaceWirePipeline::StageStatsStruct& SpaceWirePipeline::GetStageStats( StageEnum stage ) const
+{
+    return mStats[ stage ];
+}
+
+const char* SpaceWirePipeline::GetStageName( StageEnum stage )
+{
+    static const char* const kNames[ kStageCount ] = { "bit_recovery", "character_decode", "frame_emit" };
+    return kNames[ stage ];
+}
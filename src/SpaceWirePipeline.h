@@ -0,0 +1,123 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "SpaceWireBitStream.h"
+#include "SpaceWireCharacterDecoder.h"
+#include "SpaceWireRingBuffer.h"
+
+// runs character decoding on its own thread
+//
+// the channel data may only be read on the analyzer thread, so that thread recovers the bits and
+// writes them with WriteBits(), and turns the characters it gets back from ReadCharacters() into
+// frames.  the pipeline thread only decodes bits into characters in between.
+class SpaceWirePipeline
+{
+  public:
+    // stages of a pipelined decode, the first and last run on the analyzer thread
+    enum StageEnum
+    {
+        // reading edges and recovering bits
+        kStageRecovery,
+        // decoding bits into characters (on the decode thread)
+        kStageDecode,
+        // turning characters into frames
+        kStageEmit,
+        kStageCount,
+    };
+
+    // throughput counter of a stage
+    struct StageStatsStruct
+    {
+        // number of bits, characters or frames produced
+        U64 items;
+        // time spent working, excluding time spent waiting for the other stages
+        double busySeconds;
+    };
+
+    // stops a pipeline when it goes out of scope, so the decode thread is joined on every way out
+    // of a decode loop (including the SDK unwinding the analyzer thread)
+    class StopGuard
+    {
+      public:
+        explicit StopGuard( SpaceWirePipeline& pipeline ) : mPipeline( pipeline )
+        {
+        }
+        ~StopGuard()
+        {
+            mPipeline.Stop();
+        }
+
+      protected:
+        StopGuard( const StopGuard& );
+        StopGuard& operator=( const StopGuard& );
+
+        SpaceWirePipeline& mPipeline;
+    };
+
+    SpaceWirePipeline();
+    ~SpaceWirePipeline();
+
+    // start the decode thread
+    void Start( bool desyncAfterError );
+    // queue as many bits as there is room for without waiting, returns the number queued
+    U32 WriteBits( const RecoveredBitStruct* bits, U32 count );
+    // wait until there is room for more bits
+    void WaitForBitSpace();
+    // mark the end of the bits
+    void CloseBits();
+    // return up to maxCount decoded characters without waiting, 0 if none are ready yet
+    U32 TryReadCharacters( DecodedCharacterStruct* characters, U32 maxCount );
+    // wait for up to maxCount decoded characters, returns 0 once CloseBits() was called and all
+    // characters have been read
+    U32 ReadCharacters( DecodedCharacterStruct* characters, U32 maxCount );
+    // stop and join the decode thread
+    void Stop();
+
+    // time the work of a stage, which produced items, on the thread running the stage
+    // (only counted in instrumented builds, like SpaceWireInstrumentation)
+#ifdef SPACEWIRE_INSTRUMENTATION
+    void StartStage( StageEnum stage )
+    {
+        mStageStarted[ stage ] = Clock::now();
+    }
+    void StopStage( StageEnum stage, U64 items )
+    {
+        mStats[ stage ].busySeconds += std::chrono::duration<double>( Clock::now() - mStageStarted[ stage ] ).count();
+        mStats[ stage ].items += items;
+    }
+#else
+    void StartStage( StageEnum )
+    {
+    }
+    void StopStage( StageEnum, U64 )
+    {
+    }
+#endif
+
+    // return the throughput counter of a stage (final for the decode stage once Stop() returned)
+    const StageStatsStruct& GetStageStats( StageEnum stage ) const;
+    // return the name of a stage
+    static const char* GetStageName( StageEnum stage );
+
+  protected:
+    typedef std::chrono::steady_clock Clock;
+
+    // decode bits into characters
+    void DecodeStage();
+
+    // number of items decoded at a time
+    static const U32 kBlockSize = 4096;
+
+    SpaceWireCharacterDecoder mDecoder;
+
+    SpaceWireRingBuffer<RecoveredBitStruct> mBitRing;
+    SpaceWireRingBuffer<DecodedCharacterStruct> mCharacterRing;
+
+    std::thread mDecodeThread;
+
+    StageStatsStruct mStats[ kStageCount ];
+    Clock::time_point mStageStarted[ kStageCount ];
+};
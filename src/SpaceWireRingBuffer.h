@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+// lock-free ring buffer between a single producer thread and a single consumer thread
+//
+// a thread that has to wait spins briefly and then blocks on a condition variable.  the other
+// side only takes the lock to wake it when a waiter is registered, so reads and writes stay
+// lock-free while both sides keep up.
+template <typename T>
+class SpaceWireRingBuffer
+{
+  public:
+    // capacity must be a power of two
+    explicit SpaceWireRingBuffer( U32 capacity ) : mItems( capacity ), mMask( capacity - 1 )
+    {
+        Reset();
+    }
+
+    // empty the buffer (only while neither thread is using it)
+    void Reset()
+    {
+        mWriteIndex.store( 0 );
+        mReadIndex.store( 0 );
+        mClosed.store( false );
+        mAborted.store( false );
+        mWaiters.store( 0 );
+    }
+
+    // write all items, waiting for space as needed
+    // returns false if the buffer was aborted
+    bool Write( const T* items, U32 count )
+    {
+        while( count != 0 )
+        {
+            U32 n = TryWrite( items, count );
+            if( n == 0 )
+            {
+                if( !WaitForSpace() )
+                {
+                    return false;
+                }
+                continue;
+            }
+            items += n;
+            count -= n;
+        }
+        return true;
+    }
+
+    // write as many items as there is space for without waiting, returns the number written
+    U32 TryWrite( const T* items, U32 count )
+    {
+        U64 write = mWriteIndex.load( std::memory_order_relaxed );
+        U64 free = mItems.size() - ( write - mReadIndex.load( std::memory_order_acquire ) );
+        U32 n = ( count < free ) ? count : ( U32 )free;
+        for( U32 i = 0; i < n; ++i )
+        {
+            mItems[ ( write + i ) & mMask ] = items[ i ];
+        }
+        if( n != 0 )
+        {
+            mWriteIndex.store( write + n, std::memory_order_release );
+            WakeWaiters();
+        }
+        return n;
+    }
+
+    // read up to maxCount items, waiting until at least one is available
+    // returns 0 once the buffer is closed and empty, or aborted
+    U32 Read( T* items, U32 maxCount )
+    {
+        while( true )
+        {
+            // check for closure before looking at the write index so no items are missed
+            bool closed = mClosed.load( std::memory_order_acquire );
+            U32 n = TryRead( items, maxCount );
+            if( n != 0 )
+            {
+                return n;
+            }
+            if( closed || mAborted.load( std::memory_order_relaxed ) )
+            {
+                return 0;
+            }
+            WaitForItems();
+        }
+    }
+
+    // read up to maxCount items without waiting, returns 0 if none are available
+    U32 TryRead( T* items, U32 maxCount )
+    {
+        U64 read = mReadIndex.load( std::memory_order_relaxed );
+        U64 available = mWriteIndex.load( std::memory_order_acquire ) - read;
+        U32 n = ( maxCount < available ) ? maxCount : ( U32 )available;
+        for( U32 i = 0; i < n; ++i )
+        {
+            items[ i ] = mItems[ ( read + i ) & mMask ];
+        }
+        if( n != 0 )
+        {
+            mReadIndex.store( read + n, std::memory_order_release );
+            WakeWaiters();
+        }
+        return n;
+    }
+
+    // mark the end of the stream (called by the producer)
+    void Close()
+    {
+        mClosed.store( true, std::memory_order_release );
+        WakeAll();
+    }
+
+    // stop both sides, further reads and writes return immediately
+    void Abort()
+    {
+        mAborted.store( true );
+        WakeAll();
+    }
+
+    // wait until there is space for at least one item (called by the producer)
+    // returns false if the buffer was aborted
+    bool WaitForSpace()
+    {
+        Wait( &SpaceWireRingBuffer::HasSpace );
+        return !mAborted.load( std::memory_order_relaxed );
+    }
+
+    // wait until at least one item is available or the buffer is closed (called by the consumer)
+    void WaitForItems()
+    {
+        Wait( &SpaceWireRingBuffer::HasItems );
+    }
+
+  protected:
+    // number of times a waiting thread checks again before it blocks
+    static const U32 kSpinCount = 64;
+
+    bool HasSpace() const
+    {
+        return mWriteIndex.load( std::memory_order_relaxed ) - mReadIndex.load( std::memory_order_acquire ) < mItems.size() ||
+               mAborted.load( std::memory_order_relaxed );
+    }
+
+    bool HasItems() const
+    {
+        return mWriteIndex.load( std::memory_order_acquire ) != mReadIndex.load( std::memory_order_relaxed ) ||
+               mClosed.load( std::memory_order_acquire ) || mAborted.load( std::memory_order_relaxed );
+    }
+
+    // spin for a while, then block until ready() holds
+    void Wait( bool ( SpaceWireRingBuffer::*ready )() const )
+    {
+        for( U32 i = 0; i < kSpinCount; ++i )
+        {
+            if( ( this->*ready )() )
+            {
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        // register before checking again under the lock, so an index update either is seen here
+        // or sees the waiter and wakes it
+        std::unique_lock<std::mutex> lock( mMutex );
+        mWaiters.fetch_add( 1 );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        while( !( this->*ready )() )
+        {
+            mChanged.wait( lock );
+        }
+        mWaiters.fetch_sub( 1 );
+    }
+
+    // wake the other side if it is blocked (after an index update)
+    void WakeWaiters()
+    {
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if( mWaiters.load( std::memory_order_relaxed ) != 0 )
+        {
+            WakeAll();
+        }
+    }
+
+    void WakeAll()
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mChanged.notify_all();
+    }
+
+    std::vector<T> mItems;
+    U64 mMask;
+
+    // producer and consumer indices are padded onto separate cache lines
+    // (padding rather than alignas, which operator new ignores before C++17)
+    enum
+    {
+        kCacheLineSize = 64
+    };
+    U8 mPad0[ kCacheLineSize ];
+    std::atomic<U64> mWriteIndex;
+    U8 mPad1[ kCacheLineSize - sizeof( std::atomic<U64> ) ];
+    std::atomic<U64> mReadIndex;
+    U8 mPad2[ kCacheLineSize - sizeof( std::atomic<U64> ) ];
+    std::atomic<bool> mClosed;
+    std::atomic<bool> mAborted;
+
+    // number of threads blocked in Wait()
+    std::atomic<U32> mWaiters;
+    std::mutex mMutex;
+    std::condition_variable mChanged;
+};
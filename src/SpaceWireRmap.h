@@ -0,0 +1,144 @@
+#pragma once
+
+#include <unordered_map>
+
+#include <LogicPublicTypes.h>
+
+// header fields of an RMAP (remote memory access protocol, ECSS-E-ST-50-52C) command or reply
+struct RmapPacketStruct
+{
+    // problems found in the packet
+    enum ErrorEnum : U8
+    {
+        kErrorNone,
+        // the packet ends inside the header
+        kErrorTruncated,
+        kErrorHeaderCrc,
+        // the packet length does not match the data length field
+        kErrorDataLength,
+        kErrorDataCrc,
+    };
+
+    // instruction bits
+    enum InstructionEnum : U8
+    {
+        kInstructionCommand = 1 << 6,
+        kInstructionWrite = 1 << 5,
+        kInstructionVerify = 1 << 4,
+        kInstructionReply = 1 << 3,
+        kInstructionIncrement = 1 << 2,
+        kInstructionReplyAddressLength = 0b11,
+    };
+
+    U8 instruction;
+    // key of a command, or status of a reply
+    U8 keyOrStatus;
+    U8 targetAddress;
+    U8 initiatorAddress;
+    U16 transactionId;
+    // address fields (commands only)
+    U8 extendedAddress;
+    U32 address;
+    // data length field (packets which carry data, 0 otherwise)
+    U32 dataLength;
+    // offset of the first header byte (after any leading path address bytes), and of the data
+    U32 headerOffset;
+    U32 dataOffset;
+    U8 error;
+
+    bool IsCommand() const
+    {
+        return ( instruction & kInstructionCommand ) != 0;
+    }
+    bool IsWrite() const
+    {
+        return ( instruction & kInstructionWrite ) != 0;
+    }
+    // true for read-modify-write commands and their replies (write clear, verify and reply set)
+    bool IsReadModifyWrite() const
+    {
+        return ( instruction & ( kInstructionWrite | kInstructionVerify | kInstructionReply ) ) == ( kInstructionVerify | kInstructionReply );
+    }
+    // true if a data field and data CRC follow the header: write commands, read replies and both
+    // halves of a read-modify-write
+    bool HasData() const
+    {
+        return IsReadModifyWrite() || ( IsCommand() ? IsWrite() : !IsWrite() );
+    }
+    // true for commands which ask for a reply
+    bool WantsReply() const
+    {
+        return ( instruction & kInstructionReply ) != 0;
+    }
+    // true if the header fields can be trusted
+    bool HasValidHeader() const
+    {
+        return error != kErrorTruncated && error != kErrorHeaderCrc;
+    }
+};
+
+// an RMAP command and its reply
+struct RmapTransactionStruct
+{
+    // header of the command
+    RmapPacketStruct command;
+    // header of the reply, valid if replied is true
+    RmapPacketStruct reply;
+    bool replied;
+
+    // sdk packets of the command and the reply (INVALID_RESULT_INDEX if not shown as packets)
+    U64 commandPacketId;
+    U64 replyPacketId;
+
+    U64 commandStartingSample;
+    U64 commandEndingSample;
+    U64 replyStartingSample;
+    U64 replyEndingSample;
+};
+
+// decodes RMAP packets
+class SpaceWireRmap
+{
+  public:
+    // protocol identifier of RMAP, the byte after the logical address
+    static const U8 kProtocolId = 0x01;
+
+    // return the RMAP CRC-8 of data, continuing from crc
+    static U8 Crc( const U8* data, U64 length, U8 crc = 0 );
+
+    // decode a packet of length bytes of which the first storedLength are in data
+    // returns false if it is not an RMAP packet, and the data CRC is only checked if all bytes
+    // are stored.  leading path address bytes (below 32) are skipped
+    static bool Decode( const U8* data, U64 storedLength, U64 length, RmapPacketStruct& packet );
+};
+
+// pairs RMAP commands with their replies by initiator, target and transaction id
+class SpaceWireRmapMatcher
+{
+  public:
+    SpaceWireRmapMatcher();
+
+    // forget all outstanding commands
+    void Reset();
+
+    // add a command which wants a reply, as transaction transactionIndex
+    // returns true if an earlier command with the same key never got its reply
+    bool AddCommand( const RmapPacketStruct& command, U64 transactionIndex );
+    // find and remove the command a reply belongs to, returns false if there is none
+    bool MatchReply( const RmapPacketStruct& reply, U64& transactionIndex );
+
+    // return the number of commands waiting for a reply
+    U64 GetOutstanding() const
+    {
+        return mOutstanding.size();
+    }
+
+  protected:
+    static U64 Key( U8 initiatorAddress, U8 targetAddress, U16 transactionId )
+    {
+        return ( ( U64 )initiatorAddress << 24 ) | ( ( U64 )targetAddress << 16 ) | transactionId;
+    }
+
+    // transaction index by key
+    std::unordered_map<U64, U64> mOutstanding;
+};
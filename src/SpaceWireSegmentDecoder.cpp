@@ -0,0 +1,193 @@
+#include "SpaceWireSegmentDecoder.h"
+
+#include <algorithm>
+
+SpaceWireSegmentDecoder::SpaceWireSegmentDecoder()
+    : mThreadCount( 0 ), mDesyncAfterError( true ), mFirstSegment( true ), mBusy( 0 ), mStopping( false )
+{
+}
+
+SpaceWireSegmentDecoder::~SpaceWireSegmentDecoder()
+{
+    StopWorkers();
+}
+
+void SpaceWireSegmentDecoder::Reset( U32 threadCount, bool desyncAfterError )
+{
+    Cancel();
+    threadCount = std::max( threadCount, 1u );
+    if( threadCount != mThreadCount )
+    {
+        StopWorkers();
+        mThreadCount = threadCount;
+        mStopping = false;
+        for( U32 i = 0; i < mThreadCount; ++i )
+        {
+            mWorkers.push_back( std::thread( &SpaceWireSegmentDecoder::Worker, this ) );
+        }
+    }
+    mDesyncAfterError = desyncAfterError;
+    mFirstSegment = true;
+    mCarry.Reset();
+    mCarry.SetDesyncAfterError( desyncAfterError );
+}
+
+void SpaceWireSegmentDecoder::Cancel()
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+    mQueue.clear();
+    mDecoded.wait( lock, [ this ] { return mBusy == 0; } );
+    lock.unlock();
+
+    while( !mPending.empty() )
+    {
+        mFree.push_back( std::move( mPending.front() ) );
+        mPending.pop_front();
+    }
+}
+
+void SpaceWireSegmentDecoder::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mStopping = true;
+    }
+    mQueued.notify_all();
+    for( std::vector<std::thread>::iterator it = mWorkers.begin(); it != mWorkers.end(); ++it )
+    {
+        it->join();
+    }
+    mWorkers.clear();
+}
+
+bool SpaceWireSegmentDecoder::IsEmpty() const
+{
+    return mPending.empty();
+}
+
+bool SpaceWireSegmentDecoder::IsFull() const
+{
+    return mPending.size() >= mThreadCount;
+}
+
+void SpaceWireSegmentDecoder::Submit( std::vector<RecoveredBitStruct>& bits )
+{
+    std::unique_ptr<SegmentStruct> segment;
+    if( !mFree.empty() )
+    {
+        segment = std::move( mFree.back() );
+        mFree.pop_back();
+    }
+    else
+    {
+        segment.reset( new SegmentStruct );
+    }
+    segment->bits.swap( bits );
+    segment->characters.clear();
+    segment->decoder.Reset();
+    segment->decoder.SetDesyncAfterError( mDesyncAfterError );
+    segment->decoded = false;
+
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mQueue.push_back( segment.get() );
+    }
+    mQueued.notify_one();
+    mPending.push_back( std::move( segment ) );
+}
+
+void SpaceWireSegmentDecoder::Worker()
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+    while( true )
+    {
+        mQueued.wait( lock, [ this ] { return mStopping || !mQueue.empty(); } );
+        if( mStopping )
+        {
+            return;
+        }
+        SegmentStruct* segment = mQueue.front();
+        mQueue.pop_front();
+        ++mBusy;
+
+        lock.unlock();
+        DecodeSegment( segment );
+        lock.lock();
+
+        segment->decoded = true;
+        --mBusy;
+        mDecoded.notify_all();
+    }
+}
+
+void SpaceWireSegmentDecoder::DecodeSegment( SegmentStruct* segment )
+{
+    // roughly one character per eight bits
+    segment->characters.reserve( segment->bits.size() / 8 );
+    segment->decoder.Decode( segment->bits.data(), ( U32 )segment->bits.size(), segment->characters );
+}
+
+bool SpaceWireSegmentDecoder::IsCharacter( const DecodedCharacterStruct& character )
+{
+    return character.type == DecodedCharacterStruct::kControl || character.type == DecodedCharacterStruct::kData;
+}
+
+U64 SpaceWireSegmentDecoder::Collect( std::vector<DecodedCharacterStruct>& characters )
+{
+    std::unique_ptr<SegmentStruct> pending = std::move( mPending.front() );
+    mPending.pop_front();
+    {
+        std::unique_lock<std::mutex> lock( mMutex );
+        mDecoded.wait( lock, [ &pending ] { return pending->decoded; } );
+    }
+    // the segment's storage is reused by a later Submit() once this returns
+    SegmentStruct& segment = *pending;
+    mFree.push_back( std::move( pending ) );
+    U64 lastSample = segment.bits.back().firstSample;
+
+    // the first segment starts where a serial decode would
+    if( mFirstSegment )
+    {
+        mFirstSegment = false;
+        characters.insert( characters.end(), segment.characters.begin(), segment.characters.end() );
+        mCarry = segment.decoder;
+        return lastSample;
+    }
+
+    // run the carried decoder until it agrees with the segment decode
+    const U32 kStitchStep = 32;
+    const std::vector<DecodedCharacterStruct>& speculative = segment.characters;
+    size_t match = 0;
+    mStitched.clear();
+    for( size_t i = 0; i < segment.bits.size(); i += kStitchStep )
+    {
+        size_t first = mStitched.size();
+        U32 count = ( U32 )std::min<size_t>( kStitchStep, segment.bits.size() - i );
+        mCarry.Decode( &segment.bits[ i ], count, mStitched );
+
+        for( size_t k = first; k < mStitched.size(); ++k )
+        {
+            if( !IsCharacter( mStitched[ k ] ) )
+            {
+                continue;
+            }
+            U64 start = mStitched[ k ].startingSample;
+            while( match < speculative.size() && speculative[ match ].startingSample < start )
+            {
+                ++match;
+            }
+            if( match < speculative.size() && speculative[ match ].startingSample == start && IsCharacter( speculative[ match ] ) )
+            {
+                // both decodes agree from here on
+                characters.insert( characters.end(), mStitched.begin(), mStitched.begin() + k );
+                characters.insert( characters.end(), speculative.begin() + match, speculative.end() );
+                mCarry = segment.decoder;
+                return lastSample;
+            }
+        }
+    }
+
+    // the segment decode never lined up, so the carried decode covers the whole segment
+    characters.insert( characters.end(), mStitched.begin(), mStitched.end() );
+    return lastSample;
+}
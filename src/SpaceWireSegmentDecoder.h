@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SpaceWireCharacterDecoder.h"
+
+// decodes consecutive segments of recovered bits into characters on a pool of worker threads
+//
+// the bits of each segment are still read from the edges by the caller, one segment after the
+// other, so this only takes the character decoding off that thread.
+//
+// each segment is decoded from its first bit without knowing where the previous segment left off.
+// when a segment is collected, the decoder state carried over from the previous segment is run
+// over the start of the segment until it produces a character that the segment decode also
+// produced.  from that character on both decodes are identical, so the stitched result is the same
+// as decoding the whole capture serially.
+class SpaceWireSegmentDecoder
+{
+  public:
+    // number of bits in a full segment
+    static const U32 kSegmentBits = 1 << 18;
+
+    SpaceWireSegmentDecoder();
+    ~SpaceWireSegmentDecoder();
+
+    // start a new decode using threadCount worker threads (the pool is only restarted if the
+    // count changes)
+    void Reset( U32 threadCount, bool desyncAfterError );
+
+    // return true if no segments are waiting to be collected
+    bool IsEmpty() const;
+    // return true if a segment should be collected before more are submitted
+    bool IsFull() const;
+
+    // queue a segment for decoding (the contents of bits are taken over, and bits is given the
+    // storage of an earlier segment to reuse)
+    void Submit( std::vector<RecoveredBitStruct>& bits );
+    // wait for the oldest submitted segment and append its stitched characters to characters
+    // returns the first sample of the last bit in the segment
+    U64 Collect( std::vector<DecodedCharacterStruct>& characters );
+
+  protected:
+    // a segment and the result of decoding it
+    struct SegmentStruct
+    {
+        std::vector<RecoveredBitStruct> bits;
+        std::vector<DecodedCharacterStruct> characters;
+        // decoder state at the end of the segment
+        SpaceWireCharacterDecoder decoder;
+        // set by the worker once characters and decoder are final (guarded by mMutex)
+        bool decoded;
+    };
+
+    // take queued segments and decode them until told to stop
+    void Worker();
+
+    // decode a segment from an unsynchronized start (runs on a worker thread)
+    static void DecodeSegment( SegmentStruct* segment );
+
+    // return true if the character is a real control or data character
+    static bool IsCharacter( const DecodedCharacterStruct& character );
+
+    // drop queued segments and wait for those being decoded
+    void Cancel();
+    // stop and join the worker threads
+    void StopWorkers();
+
+    // submitted segments in order, until they are collected
+    std::deque<std::unique_ptr<SegmentStruct>> mPending;
+    // collected segments kept for their storage
+    std::vector<std::unique_ptr<SegmentStruct>> mFree;
+    U32 mThreadCount;
+    bool mDesyncAfterError;
+
+    // true until the first segment has been collected
+    bool mFirstSegment;
+    // decoder state at the end of the last collected segment
+    SpaceWireCharacterDecoder mCarry;
+    // characters decoded by mCarry while stitching
+    std::vector<DecodedCharacterStruct> mStitched;
+
+    std::vector<std::thread> mWorkers;
+    // guards mQueue, mBusy, mStopping and SegmentStruct::decoded
+    std::mutex mMutex;
+    // signalled when a segment is queued or the workers are to stop
+    std::condition_variable mQueued;
+    // signalled when a worker finishes a segment
+    std::condition_variable mDecoded;
+    // segments waiting for a worker
+    std::deque<SegmentStruct*> mQueue;
+    // number of segments being decoded
+    U32 mBusy;
+    bool mStopping;
+};
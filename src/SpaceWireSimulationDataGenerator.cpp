@@ -1,10 +1,25 @@
 #include "SpaceWireSimulationDataGenerator.h"
+#include "SpaceWireAnalyzer.h"
 #include "SpaceWireAnalyzerSettings.h"
+#include "SpaceWireCreditTracker.h"
 
 #include <AnalyzerHelpers.h>
 
-SpaceWireSimulationDataGenerator::SpaceWireSimulationDataGenerator() : mNextData( 0 )
+SpaceWireSimulationDataGenerator::SpaceWireSimulationDataGenerator() : mHasReverse( false )
 {
+    mTraffic.startupRateBps = 10000000;
+    mTraffic.linkRateBps = 10000000;
+    mTraffic.startupNulls = 16;
+    mTraffic.minPacketLength = 4;
+    mTraffic.maxPacketLength = 1024;
+    mTraffic.nullsBetweenPackets = 4;
+    mTraffic.timecodePeriodUs = 100;
+    mTraffic.seed = 1;
+    for( U32 i = 0; i < SimulationTrafficStruct::kFaultCount; ++i )
+    {
+        mTraffic.faultRatePpm[ i ] = 0;
+    }
+    mTraffic.faultSeed = 1;
 }
 
 SpaceWireSimulationDataGenerator::~SpaceWireSimulationDataGenerator()
@@ -17,74 +32,319 @@ void SpaceWireSimulationDataGenerator::Initialize( U32 simulation_sample_rate, S
 	mSettings = settings;
 
 	mData = mSpaceWireSimulationChannels.Add( settings->mDataChannel, mSimulationSampleRateHz, BIT_LOW );
-    mStrobe = mSpaceWireSimulationChannels.Add( settings->mDataChannel, mSimulationSampleRateHz, BIT_LOW );
+    mStrobe = mSpaceWireSimulationChannels.Add( settings->mStrobeChannel, mSimulationSampleRateHz, BIT_LOW );
+    mHasReverse = settings->HasReverseChannels();
+    if( mHasReverse )
+    {
+        mReverseData = mSpaceWireSimulationChannels.Add( settings->mReverseDataChannel, mSimulationSampleRateHz, BIT_LOW );
+        mReverseStrobe = mSpaceWireSimulationChannels.Add( settings->mReverseStrobeChannel, mSimulationSampleRateHz, BIT_LOW );
+    }
 
-    mSpaceWireSimulationChannels.AdvanceAll( mSimulationSampleRateHz / 10000000 );
+    // the decoder needs at least two samples per bit
+    mTraffic.linkRateBps = ( U64 )settings->mSimulationRateMbps * 1000000;
+    if( mTraffic.linkRateBps > mSimulationSampleRateHz / 2 )
+    {
+        mTraffic.linkRateBps = mSimulationSampleRateHz / 2;
+    }
+    if( mTraffic.startupRateBps > mTraffic.linkRateBps )
+    {
+        mTraffic.startupRateBps = mTraffic.linkRateBps;
+    }
 
+    if( settings->mSimulationPackets == SpaceWireAnalyzerSettings::kPacketsSmall )
+    {
+        mTraffic.minPacketLength = 4;
+        mTraffic.maxPacketLength = 64;
+    }
+    else if( settings->mSimulationPackets == SpaceWireAnalyzerSettings::kPacketsLarge )
+    {
+        mTraffic.minPacketLength = 1024;
+        mTraffic.maxPacketLength = 65536;
+    }
+    else
+    {
+        mTraffic.minPacketLength = 4;
+        mTraffic.maxPacketLength = 1024;
+    }
+    mTraffic.nullsBetweenPackets = settings->mSimulationNulls;
+    mTraffic.timecodePeriodUs = settings->mSimulationTimecodePeriodUs;
+    // xorshift never leaves a zero state
+    mTraffic.seed = ( settings->mSimulationSeed != 0 ) ? settings->mSimulationSeed : 1;
+
+    mNextData = 0;
+    mTimecode = 0;
+    // the chosen kind of fault, or every kind, at the rate of the setting
+    U32 faultRatePpm = 0;
+    if( settings->mSimulationFaults == SpaceWireAnalyzerSettings::kFaultsRare )
+    {
+        faultRatePpm = 10;
+    }
+    else if( settings->mSimulationFaults == SpaceWireAnalyzerSettings::kFaultsFrequent )
+    {
+        faultRatePpm = 1000;
+    }
+    mFaultsEnabled = false;
+    for( U32 i = 0; i < SimulationTrafficStruct::kFaultCount; ++i )
+    {
+        bool chosen = settings->mSimulationFaultKind == SimulationTrafficStruct::kFaultCount || settings->mSimulationFaultKind == i;
+        mTraffic.faultRatePpm[ i ] = ( chosen ) ? faultRatePpm : 0;
+        mFaultsEnabled = mFaultsEnabled || mTraffic.faultRatePpm[ i ] != 0;
+    }
+    mTraffic.faultSeed = ( settings->mSimulationFaultSeed != 0 ) ? settings->mSimulationFaultSeed : 1;
+
+    mRandom = mTraffic.seed;
+    mFaultRandom = mTraffic.faultSeed;
+
+    U64 firstSample = mSimulationSampleRateHz / mTraffic.startupRateBps;
+    mForward.Reset( firstSample );
+    mReverse.Reset( firstSample + firstSample / 2 );
+    StartLink();
 }
 
 U32 SpaceWireSimulationDataGenerator::GenerateSimulationData( U64 largest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels )
 {
 	U64 adjusted_largest_sample_requested = AnalyzerHelpers::AdjustSimulationTargetSample( largest_sample_requested, sample_rate, mSimulationSampleRateHz );
 
-	// 10 Mbit
-    U32 samples_per_bit = (mSimulationSampleRateHz + 5000000) / 10000000;
-
-	while( mData->GetCurrentSampleNumber() < adjusted_largest_sample_requested )
+    // encode whole characters, then hand over the edges of the batch at once
+	while( mForward.GetSample() < adjusted_largest_sample_requested )
 	{
-		// create this data bit, MSB first
-        uint8_t x = mNextData++;
-        for( int i = 0; i < 8; ++i )
+        AddForwardCharacter();
+        if( mHasReverse )
         {
-            BitState target_data_state = ( x & 0x80 ) ? BIT_HIGH : BIT_LOW;
-            x <<= 1;
-
-            if( mData->GetCurrentBitState() == target_data_state)
-            {
-                mData->Transition();
-            }
-            else
-            {
-                mStrobe->Transition();
-            }
-            mSpaceWireSimulationChannels.AdvanceAll( samples_per_bit );
+            CatchUpReverse();
         }
 	}
+    FlushEdges( mForward, mData, mStrobe );
+    if( mHasReverse )
+    {
+        FlushEdges( mReverse, mReverseData, mReverseStrobe );
+    }
+    else
+    {
+        // link restarts still encode the reverse handshake
+        mReverse.ClearEdges();
+    }
 
 	*simulation_channels = mSpaceWireSimulationChannels.GetArray();
     return mSpaceWireSimulationChannels.GetCount();
 }
 
-//void SpaceWireSimulationDataGenerator::CreateSerialByte()
-//{
-//	U32 samples_per_bit = mSimulationSampleRateHz / mSettings->mBitRate;
-//
-//	U8 byte = mSerialText[ mStringIndex ];
-//	mStringIndex++;
-//	if( mStringIndex == mSerialText.size() )
-//		mStringIndex = 0;
-//
-//	//we're currenty high
-//	//let's move forward a little
-//	mSerialSimulationData.Advance( samples_per_bit * 10 );
-//
-//	mSerialSimulationData.Transition();  //low-going edge for start bit
-//	mSerialSimulationData.Advance( samples_per_bit );  //add start bit time
-//
-//	U8 mask = 0x1 << 7;
-//	for( U32 i=0; i<8; i++ )
-//	{
-//		if( ( byte & mask ) != 0 )
-//			mSerialSimulationData.TransitionIfNeeded( BIT_HIGH );
-//		else
-//			mSerialSimulationData.TransitionIfNeeded( BIT_LOW );
-//
-//		mSerialSimulationData.Advance( samples_per_bit );
-//		mask = mask >> 1;
-//	}
-//
-//	mSerialSimulationData.TransitionIfNeeded( BIT_HIGH ); //we need to end high
-//
-//	//lets pad the end a bit for the stop bit:
-//	mSerialSimulationData.Advance( samples_per_bit );
-//}
+void SpaceWireSimulationDataGenerator::StartLink()
+{
+    // both ends start at the start-up rate, send NULLs, then FCTs for the buffer space of their
+    // receivers, and only then switch to the link rate
+    mForward.SetBitRate( mSimulationSampleRateHz, mTraffic.startupRateBps );
+    mReverse.SetBitRate( mSimulationSampleRateHz, mTraffic.startupRateBps );
+
+    U32 fcts = SpaceWireCreditTracker::kMaxCredit / SpaceWireCreditTracker::kCreditPerFct;
+    for( U32 i = 0; i < mTraffic.startupNulls; ++i )
+    {
+        mForward.AddNull();
+        mReverse.AddNull();
+    }
+    for( U32 i = 0; i < fcts; ++i )
+    {
+        mForward.AddControl( SpaceWireAnalyzer::kControlFct );
+        mReverse.AddControl( SpaceWireAnalyzer::kControlFct );
+    }
+    mCredit = fcts * SpaceWireCreditTracker::kCreditPerFct;
+    mOwedFcts = 0;
+    mReceived = 0;
+    mPacketRemaining = 0;
+    mGapRemaining = mTraffic.nullsBetweenPackets;
+    mForward.AddNull();
+    mReverse.AddNull();
+
+    mForward.SetBitRate( mSimulationSampleRateHz, mTraffic.linkRateBps );
+    mReverse.SetBitRate( mSimulationSampleRateHz, mTraffic.linkRateBps );
+    mNextTimecodeSample = mForward.GetSample() + ( U64 )mTraffic.timecodePeriodUs * mSimulationSampleRateHz / 1000000;
+}
+
+void SpaceWireSimulationDataGenerator::AddForwardCharacter()
+{
+    if( mFaultsEnabled && InjectFault() )
+    {
+        return;
+    }
+
+    // timecodes go out as soon as they are due, even inside a packet
+    if( mTraffic.timecodePeriodUs != 0 && mForward.GetSample() >= mNextTimecodeSample )
+    {
+        mForward.AddTimecode( mTimecode );
+        mTimecode = ( mTimecode + 1 ) & 0x3F;
+        mNextTimecodeSample += ( U64 )mTraffic.timecodePeriodUs * mSimulationSampleRateHz / 1000000;
+        return;
+    }
+
+    if( mPacketRemaining == 0 )
+    {
+        if( mGapRemaining != 0 )
+        {
+            --mGapRemaining;
+            mForward.AddNull();
+            return;
+        }
+        // pick a power of two, then a length between it and the next one
+        U32 low = 0;
+        U32 high = 0;
+        while( ( 1u << ( low + 1 ) ) <= mTraffic.minPacketLength )
+        {
+            ++low;
+        }
+        while( ( 1u << high ) < mTraffic.maxPacketLength )
+        {
+            ++high;
+        }
+        U32 exponent = low + Random() % ( high - low + 1 );
+        mPacketRemaining = ( 1u << exponent ) + Random() % ( 1u << exponent );
+        if( mPacketRemaining < mTraffic.minPacketLength )
+        {
+            mPacketRemaining = mTraffic.minPacketLength;
+        }
+        if( mPacketRemaining > mTraffic.maxPacketLength )
+        {
+            mPacketRemaining = mTraffic.maxPacketLength;
+        }
+        // plus one for the end of packet
+        ++mPacketRemaining;
+        mGapRemaining = mTraffic.nullsBetweenPackets;
+        // logical address
+        mNextData = 0x20 + ( Random() & 0x03 );
+    }
+
+    // without the reverse direction there is no credit to run out of
+    if( mHasReverse && mCredit == 0 )
+    {
+        mForward.AddNull();
+        return;
+    }
+
+    --mPacketRemaining;
+    if( mPacketRemaining == 0 )
+    {
+        mForward.AddControl( SpaceWireAnalyzer::kControlEop );
+    }
+    else
+    {
+        mForward.AddData( mNextData++ );
+    }
+
+    UseCredit();
+}
+
+void SpaceWireSimulationDataGenerator::UseCredit()
+{
+    if( mHasReverse )
+    {
+        // the receiver frees buffer space for every N-char, and returns it 8 at a time
+        --mCredit;
+        ++mReceived;
+        if( mReceived == SpaceWireCreditTracker::kCreditPerFct )
+        {
+            mReceived = 0;
+            ++mOwedFcts;
+        }
+    }
+}
+
+bool SpaceWireSimulationDataGenerator::InjectFault()
+{
+    U32 roll = Random( mFaultRandom ) % 1000000;
+    U32 fault = 0;
+    while( fault < SimulationTrafficStruct::kFaultCount && roll >= mTraffic.faultRatePpm[ fault ] )
+    {
+        roll -= mTraffic.faultRatePpm[ fault ];
+        ++fault;
+    }
+
+    switch( fault )
+    {
+    case SimulationTrafficStruct::kFaultParity:
+        // the character which follows carries the bad parity
+        mForward.CorruptNextParity();
+        return false;
+    case SimulationTrafficStruct::kFaultCoincidentEdges:
+        mForward.AddCoincidentEdges();
+        return true;
+    case SimulationTrafficStruct::kFaultTruncatedCharacter:
+    {
+        // a character is only cut short when the link drops, after which both ends go silent
+        // and start the link again
+        mForward.AddTruncatedData( ( U8 )Random( mFaultRandom ), 2 + Random( mFaultRandom ) % 8 );
+        U64 restartSample = mForward.GetSample() + ( U64 )kResetSilenceUs * mSimulationSampleRateHz / 1000000;
+        mForward.Disconnect( restartSample );
+        mReverse.Disconnect( restartSample + mSimulationSampleRateHz / mTraffic.startupRateBps / 2 );
+        StartLink();
+        return true;
+    }
+    case SimulationTrafficStruct::kFaultEscape:
+        mForward.AddControl( SpaceWireAnalyzer::kControlEsc );
+        mForward.AddControl( SpaceWireAnalyzer::kControlEop );
+        return true;
+    case SimulationTrafficStruct::kFaultErrorPacket:
+        if( mPacketRemaining == 0 || ( mHasReverse && mCredit == 0 ) )
+        {
+            return false;
+        }
+        mPacketRemaining = 0;
+        mForward.AddControl( SpaceWireAnalyzer::kControlEep );
+        UseCredit();
+        return true;
+    case SimulationTrafficStruct::kFaultTimecodeSkip:
+        mTimecode = ( mTimecode + 1 ) & 0x3F;
+        return false;
+    case SimulationTrafficStruct::kFaultRateChange:
+    {
+        U64 range = mTraffic.linkRateBps - mTraffic.startupRateBps;
+        U64 rate = mTraffic.startupRateBps + ( ( range != 0 ) ? Random( mFaultRandom ) % ( range + 1 ) : 0 );
+        mForward.SetBitRate( mSimulationSampleRateHz, rate );
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+void SpaceWireSimulationDataGenerator::CatchUpReverse()
+{
+    while( mReverse.GetSample() < mForward.GetSample() )
+    {
+        if( mOwedFcts != 0 )
+        {
+            --mOwedFcts;
+            mCredit += SpaceWireCreditTracker::kCreditPerFct;
+            mReverse.AddControl( SpaceWireAnalyzer::kControlFct );
+        }
+        else
+        {
+            mReverse.AddNull();
+        }
+    }
+}
+
+void SpaceWireSimulationDataGenerator::FlushEdges( SpaceWireEncoder& encoder, SimulationChannelDescriptor* data, SimulationChannelDescriptor* strobe )
+{
+    FlushEdges( encoder.GetDataEdges(), encoder.GetSample(), data );
+    FlushEdges( encoder.GetStrobeEdges(), encoder.GetSample(), strobe );
+    encoder.ClearEdges();
+}
+
+void SpaceWireSimulationDataGenerator::FlushEdges( const std::vector<U64>& edges, U64 endSample, SimulationChannelDescriptor* channel )
+{
+    // each channel only has to be touched where it changes
+    for( std::vector<U64>::const_iterator it = edges.begin(); it != edges.end(); ++it )
+    {
+        channel->Advance( ( U32 )( *it - channel->GetCurrentSampleNumber() ) );
+        channel->Transition();
+    }
+    channel->Advance( ( U32 )( endSample - channel->GetCurrentSampleNumber() ) );
+}
+
+U32 SpaceWireSimulationDataGenerator::Random( U32& state )
+{
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
@@ -1,14 +1,61 @@
 #pragma once
 
-#include <string>
-
 #include <SimulationChannelDescriptor.h>
 
+#include "SpaceWireEncoder.h"
+
 class SpaceWireAnalyzerSettings;
 
+// traffic produced by the simulation data generator
+struct SimulationTrafficStruct
+{
+    // faults which can be injected into the forward direction
+    enum FaultEnum : U32
+    {
+        // a character with the wrong parity
+        kFaultParity,
+        // data and strobe toggling on the same sample
+        kFaultCoincidentEdges,
+        // a data character cut short by the link dropping, which then starts again
+        kFaultTruncatedCharacter,
+        // ESC followed by EOP
+        kFaultEscape,
+        // a packet ended early by EEP
+        kFaultErrorPacket,
+        // a timecode value left out
+        kFaultTimecodeSkip,
+        // a switch to a random rate between the start-up and link rates
+        kFaultRateChange,
+        kFaultCount,
+    };
+
+    // rate of the start-up handshake (10 Mbit/s in the standard) and of everything after it
+    U64 startupRateBps;
+    U64 linkRateBps;
+    // NULLs sent before the FCTs of the handshake
+    U32 startupNulls;
+    // packet lengths are spread evenly over the powers of two between these
+    U32 minPacketLength;
+    U32 maxPacketLength;
+    // NULLs sent between packets
+    U32 nullsBetweenPackets;
+    // time between timecodes (0 for none)
+    U32 timecodePeriodUs;
+    // seed of the random packet lengths
+    U32 seed;
+
+    // chance of each fault before every forward character, in parts per million
+    U32 faultRatePpm[ kFaultCount ];
+    // seed of the fault injection, kept apart so faults don't change the packets
+    U32 faultSeed;
+};
+
 class SpaceWireSimulationDataGenerator
 {
 public:
+	// silence after a link reset (the standard's ErrorReset and ErrorWait times, rounded up)
+	static const U32 kResetSilenceUs = 20;
+
 	SpaceWireSimulationDataGenerator();
 	~SpaceWireSimulationDataGenerator();
 
@@ -16,17 +63,52 @@ public:
 	U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels );
 
 protected:
+	// encode the start-up handshake of both directions from where they are
+	void StartLink();
+	// encode the next character (or timecode) of the forward direction
+	void AddForwardCharacter();
+	// account for an N-char sent in the forward direction
+	void UseCredit();
+	// roll for a fault before a forward character, returns true if the fault took the character's place
+	bool InjectFault();
+	// encode NULLs and FCTs in the reverse direction up to the forward direction
+	void CatchUpReverse();
+	// move the edges of an encoder into a pair of channels, up to the encoder's next bit
+	static void FlushEdges( SpaceWireEncoder& encoder, SimulationChannelDescriptor* data, SimulationChannelDescriptor* strobe );
+	static void FlushEdges( const std::vector<U64>& edges, U64 endSample, SimulationChannelDescriptor* channel );
+	// return the next pseudo-random number from a state
+	static U32 Random( U32& state );
+	U32 Random()
+	{
+		return Random( mRandom );
+	}
+
 	SpaceWireAnalyzerSettings* mSettings;
 	U32 mSimulationSampleRateHz;
+	SimulationTrafficStruct mTraffic;
 
-protected:
-    U8 mNextData;
-	//void CreateSerialByte();
-	//std::string mSerialText;
-	//U32 mStringIndex;
+	SpaceWireEncoder mForward;
+	SpaceWireEncoder mReverse;
+	bool mHasReverse;
+
+	// bytes left in the open packet (0 between packets), and NULLs left before the next packet
+	U32 mPacketRemaining;
+	U32 mGapRemaining;
+	U8 mNextData;
+	// credit the reverse direction has given the forward one, and FCTs it still owes
+	U32 mCredit;
+	U32 mOwedFcts;
+	// forward N-chars received since the reverse direction last sent an FCT
+	U32 mReceived;
+	U8 mTimecode;
+	U64 mNextTimecodeSample;
+	U32 mRandom;
+	U32 mFaultRandom;
+	bool mFaultsEnabled;
 
 	SimulationChannelDescriptorGroup mSpaceWireSimulationChannels; 
 	SimulationChannelDescriptor * mData;
     SimulationChannelDescriptor * mStrobe;
-
+	SimulationChannelDescriptor * mReverseData;
+	SimulationChannelDescriptor * mReverseStrobe;
 };
@@ -0,0 +1,241 @@
+#include <cmath>
+#include <cstring>
+
+#include "SpaceWireTimecodeStatistics.h"
+#include "SpaceWireExportWriter.h"
+
+SpaceWireTimecodeStatistics::SpaceWireTimecodeStatistics()
+{
+    Reset();
+}
+
+void SpaceWireTimecodeStatistics::Reset()
+{
+    memset( &mStatistics, 0, sizeof( mStatistics ) );
+    mStatistics.meanPeriod = 0.0;
+    mStatistics.squaredDeviations = 0.0;
+    Restart();
+}
+
+void SpaceWireTimecodeStatistics::Restart()
+{
+    mLastTime = -1;
+    mLastStartingSample = 0;
+}
+
+bool SpaceWireTimecodeStatistics::AddTimecode( U8 value, U64 startingSample, S64& jitter )
+{
+    ++mStatistics.timecodes;
+
+    // the low 6 bits are the time, the top 2 bits are control flags
+    S32 time = value & 0x3F;
+    if( time == mLastTime )
+    {
+        // a repeated timecode is extra, so the next period still starts at the first one
+        ++mStatistics.duplicates;
+        return false;
+    }
+    S32 lastTime = mLastTime;
+    U64 period = startingSample - mLastStartingSample;
+    mLastTime = time;
+    mLastStartingSample = startingSample;
+
+    if( lastTime < 0 )
+    {
+        return false;
+    }
+    U32 skipped = ( time - lastTime - 1 ) & 0x3F;
+    if( skipped != 0 )
+    {
+        // the period spans several time values, so it says nothing about jitter
+        mStatistics.missing += skipped;
+        return false;
+    }
+
+    if( mStatistics.periods == 0 || period < mStatistics.minPeriod )
+    {
+        mStatistics.minPeriod = period;
+    }
+    if( period > mStatistics.maxPeriod )
+    {
+        mStatistics.maxPeriod = period;
+    }
+    ++mStatistics.periods;
+
+    // Welford's running mean and variance
+    double delta = ( double )period - mStatistics.meanPeriod;
+    mStatistics.meanPeriod += delta / ( double )mStatistics.periods;
+    mStatistics.squaredDeviations += delta * ( ( double )period - mStatistics.meanPeriod );
+
+    if( mStatistics.referencePeriod == 0 )
+    {
+        // collect the first periods, then average them into the reference and replay them
+        mFirstPeriods[ mStatistics.periods - 1 ] = period;
+        if( mStatistics.periods < kReferencePeriods )
+        {
+            return false;
+        }
+        U64 sum = 0;
+        for( U32 i = 0; i < kReferencePeriods; ++i )
+        {
+            sum += mFirstPeriods[ i ];
+        }
+        mStatistics.referencePeriod = ( sum + kReferencePeriods / 2 ) / kReferencePeriods;
+        for( U32 i = 0; i < kReferencePeriods; ++i )
+        {
+            AddDeviation( mFirstPeriods[ i ] );
+        }
+    }
+    else
+    {
+        AddDeviation( period );
+    }
+
+    jitter = ( S64 )period - ( S64 )mStatistics.referencePeriod;
+    return true;
+}
+
+void SpaceWireTimecodeStatistics::AddDeviation( U64 period )
+{
+    ++mStatistics.histogram[ GetBucket( ( S64 )period - ( S64 )mStatistics.referencePeriod ) ];
+}
+
+U32 SpaceWireTimecodeStatistics::GetBucket( S64 deviation )
+{
+    U32 side = ( deviation < 0 ) ? TimecodeStatisticsStruct::kBucketsPerSide : 0;
+    U64 magnitude = ( deviation < 0 ) ? ( U64 )0 - ( U64 )deviation : ( U64 )deviation;
+    if( magnitude < TimecodeStatisticsStruct::kLinearBuckets )
+    {
+        return side + ( U32 )magnitude;
+    }
+
+    // highest set bit, then the next 4 bits pick the sub-bucket
+    U32 exponent = 5;
+    while( ( magnitude >> ( exponent + 1 ) ) != 0 )
+    {
+        ++exponent;
+    }
+    U32 subBucket = ( U32 )( magnitude >> ( exponent - 4 ) ) - TimecodeStatisticsStruct::kSubBuckets;
+    return side + TimecodeStatisticsStruct::kLinearBuckets + ( exponent - 5 ) * TimecodeStatisticsStruct::kSubBuckets + subBucket;
+}
+
+void SpaceWireTimecodeStatistics::GetBucketRange( U32 bucket, S64& low, S64& high )
+{
+    bool negative = bucket >= TimecodeStatisticsStruct::kBucketsPerSide;
+    U32 index = bucket % TimecodeStatisticsStruct::kBucketsPerSide;
+
+    U64 first;
+    U64 last;
+    if( index < TimecodeStatisticsStruct::kLinearBuckets )
+    {
+        first = index;
+        last = index;
+    }
+    else
+    {
+        U32 exponent = 5 + ( index - TimecodeStatisticsStruct::kLinearBuckets ) / TimecodeStatisticsStruct::kSubBuckets;
+        U32 subBucket = ( index - TimecodeStatisticsStruct::kLinearBuckets ) % TimecodeStatisticsStruct::kSubBuckets;
+        first = ( U64 )( TimecodeStatisticsStruct::kSubBuckets + subBucket ) << ( exponent - 4 );
+        last = first + ( ( U64 )1 << ( exponent - 4 ) ) - 1;
+    }
+
+    if( negative )
+    {
+        low = -( S64 )last;
+        high = -( S64 )first;
+    }
+    else
+    {
+        low = ( S64 )first;
+        high = ( S64 )last;
+    }
+}
+
+namespace
+{
+    void WriteLine( SpaceWireExportWriter& writer, const char* name, U64 value )
+    {
+        writer.Write( name );
+        writer.WriteChar( ',' );
+        writer.WriteUnsigned( value );
+        writer.WriteChar( '\n' );
+    }
+
+    void WriteTimeLine( SpaceWireExportWriter& writer, const char* name, S64 samples )
+    {
+        writer.Write( name );
+        writer.WriteChar( ',' );
+        writer.WriteTime( samples );
+        writer.WriteChar( '\n' );
+    }
+
+    S64 Round( double value )
+    {
+        return ( S64 )std::floor( value + 0.5 );
+    }
+}
+
+void SpaceWireTimecodeStatistics::WriteReport( const TimecodeStatisticsStruct& statistics, U32 sampleRateHz, SpaceWireExportWriter& writer )
+{
+    writer.SetTimeBase( 0, sampleRateHz );
+
+    // jitter is the period minus the reference period, as in the histogram and the jitter flags
+    // (all 0 until the reference is known)
+    double mean = statistics.meanPeriod;
+    S64 minJitter = 0;
+    S64 maxJitter = 0;
+    double rmsJitter = 0.0;
+    if( statistics.referencePeriod != 0 )
+    {
+        double offset = mean - ( double )statistics.referencePeriod;
+        minJitter = ( S64 )statistics.minPeriod - ( S64 )statistics.referencePeriod;
+        maxJitter = ( S64 )statistics.maxPeriod - ( S64 )statistics.referencePeriod;
+        // the mean square deviation from the reference is the variance plus the square of the
+        // mean's offset from it
+        rmsJitter = std::sqrt( statistics.squaredDeviations / ( double )statistics.periods + offset * offset );
+    }
+
+    writer.Write( "Statistic,Value\n" );
+    WriteLine( writer, "timecodes", statistics.timecodes );
+    WriteLine( writer, "duplicate timecodes", statistics.duplicates );
+    WriteLine( writer, "missing timecodes", statistics.missing );
+    WriteLine( writer, "periods", statistics.periods );
+    WriteTimeLine( writer, "min period [s]", statistics.minPeriod );
+    WriteTimeLine( writer, "mean period [s]", Round( mean ) );
+    WriteTimeLine( writer, "max period [s]", statistics.maxPeriod );
+    WriteTimeLine( writer, "min jitter [s]", minJitter );
+    WriteTimeLine( writer, "max jitter [s]", maxJitter );
+    WriteTimeLine( writer, "peak-to-peak jitter [s]", statistics.maxPeriod - statistics.minPeriod );
+    WriteTimeLine( writer, "rms jitter [s]", Round( rmsJitter ) );
+    WriteTimeLine( writer, "reference period [s]", statistics.referencePeriod );
+
+    if( statistics.referencePeriod == 0 )
+    {
+        return;
+    }
+
+    // histogram from the most negative deviation to the most positive
+    writer.Write( "\nPeriod from [s],Period to [s],Deviation from [s],Deviation to [s],Count\n" );
+    for( U32 i = 0; i < TimecodeStatisticsStruct::kBuckets; ++i )
+    {
+        U32 bucket = ( i < TimecodeStatisticsStruct::kBucketsPerSide ) ? TimecodeStatisticsStruct::kBuckets - 1 - i
+                                                                      : i - TimecodeStatisticsStruct::kBucketsPerSide;
+        if( statistics.histogram[ bucket ] == 0 )
+        {
+            continue;
+        }
+        S64 low;
+        S64 high;
+        GetBucketRange( bucket, low, high );
+        writer.WriteTime( ( S64 )statistics.referencePeriod + low );
+        writer.WriteChar( ',' );
+        writer.WriteTime( ( S64 )statistics.referencePeriod + high );
+        writer.WriteChar( ',' );
+        writer.WriteTime( low );
+        writer.WriteChar( ',' );
+        writer.WriteTime( high );
+        writer.WriteChar( ',' );
+        writer.WriteUnsigned( statistics.histogram[ bucket ] );
+        writer.WriteChar( '\n' );
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <LogicPublicTypes.h>
+
+class SpaceWireExportWriter;
+
+// timecode period and jitter analysis
+//
+// the period between timecodes is kept as its deviation (jitter) from a reference period, the
+// mean of the first kReferencePeriods periods.  deviations go into a histogram with exact buckets
+// for small values and kSubBuckets buckets per power of two above that, so the memory used does
+// not depend on the length of the capture.
+struct TimecodeStatisticsStruct
+{
+    // linear buckets for deviations below kLinearBuckets, then kSubBuckets per power of two
+    static const U32 kLinearBuckets = 32;
+    static const U32 kSubBuckets = 16;
+    static const U32 kBucketsPerSide = kLinearBuckets + ( 64 - 5 ) * kSubBuckets;
+    // positive deviations (and zero) first, then negative ones
+    static const U32 kBuckets = 2 * kBucketsPerSide;
+
+    // timecodes received
+    U64 timecodes;
+    // timecodes repeating the previous time value, and time values skipped
+    U64 duplicates;
+    U64 missing;
+
+    // periods between consecutive time values
+    U64 periods;
+    U64 minPeriod;
+    U64 maxPeriod;
+    // running mean of the period, and sum of squared differences from it (both in samples)
+    double meanPeriod;
+    double squaredDeviations;
+
+    // period the histogram is relative to, or 0 until enough periods were seen
+    U64 referencePeriod;
+    U64 histogram[ kBuckets ];
+};
+
+// keeps timecode statistics up to date as timecodes are decoded
+class SpaceWireTimecodeStatistics
+{
+  public:
+    // number of periods averaged to get the reference period
+    static const U32 kReferencePeriods = 16;
+
+    SpaceWireTimecodeStatistics();
+
+    // clear all statistics
+    void Reset();
+    // forget the previous timecode after a loss of synchronization
+    void Restart();
+
+    // count a timecode starting at startingSample
+    // returns true and sets jitter to the period minus the reference period (in samples) if the
+    // period from the previous timecode was measured against the reference
+    bool AddTimecode( U8 value, U64 startingSample, S64& jitter );
+
+    const TimecodeStatisticsStruct& Get() const
+    {
+        return mStatistics;
+    }
+
+    // return the histogram bucket of a deviation, and the range of deviations in a bucket
+    static U32 GetBucket( S64 deviation );
+    static void GetBucketRange( U32 bucket, S64& low, S64& high );
+
+    // write the statistics and the non-empty histogram buckets as csv
+    static void WriteReport( const TimecodeStatisticsStruct& statistics, U32 sampleRateHz, SpaceWireExportWriter& writer );
+
+  protected:
+    // count a period in the histogram
+    void AddDeviation( U64 period );
+
+    TimecodeStatisticsStruct mStatistics;
+    // time value (low 6 bits) of the previous timecode, or -1 if none
+    S32 mLastTime;
+    U64 mLastStartingSample;
+    // periods seen before the reference period is known
+    U64 mFirstPeriods[ kReferencePeriods ];
+};